@@ -14,15 +14,23 @@
 #include "cling/Interpreter/InterpreterCallbacks.h"
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringSet.h"
+
+#include <memory>
+#include <vector>
 
 namespace clang {
   class Decl;
+  class DeclContext;
+  class IdentifierInfo;
   class ClassTemplateDecl;
   class NamespaceDecl;
   class FunctionDecl;
 }
 
 namespace cling {
+  class AutoloadIndex;
   class Interpreter;
   class Transaction;
 }
@@ -36,6 +44,21 @@ namespace cling {
     // The key is the Unique File ID obtained from the source manager.
     FwdDeclsMap m_Map;
     bool m_ShowSuggestions;
+    /// Binary indexes consulted lazily when a name lookup fails.
+    std::vector<std::unique_ptr<AutoloadIndex>> m_Indexes;
+    /// Names already reported from m_Indexes.
+    llvm::StringSet<> m_ReportedNames;
+    /// Unqualified names, by the context of their failed lookup, that no
+    /// index declares in any enclosing namespace. Bounded by
+    /// kMaxNotInIndexes; cleared when indexes or autoload maps are added or
+    /// a transaction is unloaded, which might free the contexts.
+    llvm::DenseSet<std::pair<const clang::DeclContext*,
+                             const clang::IdentifierInfo*>> m_NotInIndexes;
+    enum { kMaxNotInIndexes = 4096 };
+
+    /// Forgets m_NotInIndexes and the negative results of the library
+    /// manager: something new might provide the missing names.
+    void invalidateMissing();
   public:
     AutoloadCallback(cling::Interpreter* interp, bool showSuggestions = true)
       : InterpreterCallbacks(interp), m_ShowSuggestions(showSuggestions) { }
@@ -44,9 +67,25 @@ namespace cling {
     //^to get rid of bogus warning : "-Woverloaded-virtual"
     //virtual functions ARE meant to be overriden!
 
-//    bool LookupObject (clang::LookupResult &R, clang::Scope *);
+    bool LookupObject (clang::LookupResult &R, clang::Scope *) override;
     bool LookupObject (clang::TagDecl* t) override;
 
+    ///\brief Memory-maps a binary autoload index, as generated by
+    /// Interpreter::GenerateAutoloadIndex(). Names missing from the AST are
+    /// then looked up in it and reported with the header declaring them.
+    ///
+    ///\returns false and reports an error if the index could not be read.
+    ///
+    bool loadIndex(llvm::StringRef Path);
+
+    ///\brief Looks up the fully qualified Name in the loaded indexes.
+    ///
+    ///\param [out] Header - the header declaring Name.
+    ///\param [out] Library - the library defining Name; can be empty.
+    ///
+    bool lookupIndex(llvm::StringRef Name, llvm::StringRef& Header,
+                     llvm::StringRef& Library) const;
+
     void InclusionDirective(clang::SourceLocation HashLoc,
                             const clang::Token &IncludeTok,
                             llvm::StringRef FileName,
@@ -58,10 +97,13 @@ namespace cling {
                             const clang::Module *Imported,
                             clang::SrcMgr::CharacteristicKind FileType) override;
     void TransactionCommitted(const Transaction& T) override;
+    void TransactionUnloaded(const Transaction& T) override;
 
   private:
     void report(clang::SourceLocation l, llvm::StringRef name,
                 llvm::StringRef header);
+    void reportHeader(clang::SourceLocation l, llvm::StringRef name,
+                      llvm::StringRef header);
   };
 } // end namespace cling
 
@@ -35,10 +35,17 @@ namespace cling {
 
     // TODO: Add overload that takes file not MemoryBuffer
 
+    ///\brief Create the CompilerInstance of an interpreter.
+    ///
+    ///\param[out] UsesRuntimePCH - if not null, set to whether the
+    ///            ImplicitPCHInclude is the prebuilt runtime PCH, which the
+    ///            interpreter may drop if it fails to load.
+    ///
     clang::CompilerInstance*
     createCI(llvm::StringRef Code, const InvocationOptions& Opts,
              const char* LLVMDir, std::unique_ptr<clang::ASTConsumer> consumer,
-             const ModuleFileExtensions& moduleExtensions);
+             const ModuleFileExtensions& moduleExtensions,
+             bool* UsesRuntimePCH = nullptr);
 
     clang::CompilerInstance*
     createCI(MemBufPtr_t Buffer, int Argc, const char* const* Argv,
@@ -38,6 +38,11 @@ namespace cling {
     ///
     unsigned ResultEvaluation: 1;
 
+    ///\brief Whether results naming a variable with static storage refer to
+    /// it rather than copy it.
+    ///
+    unsigned BorrowResults : 1;
+
     ///\brief Whether or not to extend the static scope with new information
     /// about the names available only at runtime
     ///
@@ -81,6 +86,7 @@ namespace cling {
       EnableShadowing = 0;
       ValuePrinting = VPDisabled;
       ResultEvaluation = 0;
+      BorrowResults = 0;
       DynamicScoping = 0;
       Debug = 0;
       CodeGeneration = 1;
@@ -96,6 +102,7 @@ namespace cling {
         EnableShadowing       == Other.EnableShadowing &&
         ValuePrinting         == Other.ValuePrinting &&
         ResultEvaluation      == Other.ResultEvaluation &&
+        BorrowResults         == Other.BorrowResults &&
         DynamicScoping        == Other.DynamicScoping &&
         Debug                 == Other.Debug &&
         CodeGeneration        == Other.CodeGeneration &&
@@ -112,6 +119,7 @@ namespace cling {
         EnableShadowing       != Other.EnableShadowing ||
         ValuePrinting         != Other.ValuePrinting ||
         ResultEvaluation      != Other.ResultEvaluation ||
+        BorrowResults         != Other.BorrowResults ||
         DynamicScoping        != Other.DynamicScoping ||
         Debug                 != Other.Debug ||
         CodeGeneration        != Other.CodeGeneration ||
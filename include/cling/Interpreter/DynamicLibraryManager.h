@@ -17,7 +17,10 @@
 
 #include "llvm/Support/Path.h"
 
+#include <memory>
+
 namespace cling {
+  class DirectoryContentCache;
   class Dyld;
   class InterpreterCallbacks;
 
@@ -66,6 +69,20 @@ namespace cling {
 
     Dyld* m_Dyld = nullptr;
 
+    ///\brief Listings of the directories probed for libraries.
+    ///
+    std::unique_ptr<DirectoryContentCache> m_DirCache;
+
+    ///\brief Symbols searchLibrariesForSymbol() found in no library.
+    /// Bounded by kMaxMissingSymbols; cleared by invalidateMissing().
+    ///
+    mutable llvm::StringSet<> m_MissingSymbols;
+    enum { kMaxMissingSymbols = 1024 };
+
+    ///\brief See getGeneration().
+    ///
+    unsigned m_Generation = 0;
+
     ///\brief Concatenates current include paths and the system include paths
     /// and performs a lookup for the filename.
     /// See more information for RPATH and RUNPATH: https://en.wikipedia.org/wiki/Rpath
@@ -108,6 +125,11 @@ namespace cling {
     DynamicLibraryManager(const DynamicLibraryManager&) = delete;
     DynamicLibraryManager& operator=(const DynamicLibraryManager&) = delete;
 
+    ///\brief Returns the cache of the directory listings used to probe for
+    /// libraries.
+    ///
+    DirectoryContentCache& getDirectoryCache() const { return *m_DirCache; }
+
     InterpreterCallbacks* getCallbacks() { return m_Callbacks; }
     const InterpreterCallbacks* getCallbacks() const { return m_Callbacks; }
     void setCallbacks(InterpreterCallbacks* C) { m_Callbacks = C; }
@@ -127,9 +149,24 @@ namespace cling {
             if (dir.equals(item.Path)) return;
           auto pos = prepend ? m_SearchPaths.begin() : m_SearchPaths.end();
           m_SearchPaths.insert(pos, SearchPathInfo{dir.str(), isUser});
+          invalidateMissing();
        }
     }
 
+    ///\brief Counts the changes that can make a missing symbol or type
+    /// available: added search paths, loaded or unloaded libraries and added
+    /// autoload maps. Negative lookup results cached elsewhere are valid for
+    /// one generation.
+    ///
+    unsigned getGeneration() const { return m_Generation; }
+
+    ///\brief Forgets all negative lookup results, see getGeneration().
+    ///
+    void invalidateMissing() {
+      ++m_Generation;
+      m_MissingSymbols.clear();
+    }
+
     ///\brief Looks up a library taking into account the current include paths
     /// and the system include paths.
     /// See more information for RPATH and RUNPATH: https://en.wikipedia.org/wiki/Rpath
@@ -184,6 +221,7 @@ namespace cling {
     ///\param[in] searchSystem - whether to decend into system libraries.
     ///
     ///\returns the library name if found, and empty string otherwise.
+    /// Symbols found nowhere are remembered until invalidateMissing().
     ///
     std::string searchLibrariesForSymbol(llvm::StringRef mangledName,
                                          bool searchSystem = true) const;
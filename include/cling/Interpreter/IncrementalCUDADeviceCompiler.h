@@ -11,13 +11,16 @@
 #define CLING_INCREMENTAL_CUDA_DEVICE_JIT_H
 
 #include "clang/Basic/CodeGenOptions.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/TargetParser/Triple.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace cling {
+  class CUDAFatbinFileSystem;
   class InvocationOptions;
   class Transaction;
   class Interpreter;
@@ -30,7 +33,9 @@ namespace clang {
 } // namespace clang
 
 namespace llvm {
+  class Module;
   class StringRef;
+  class TargetMachine;
 }
 
 namespace cling {
@@ -82,8 +87,15 @@ namespace cling {
     /// folder. Have to end with a separator. Can be empty.
     const std::string m_FilePath;
     ///\brief Path to the fatbin file, which will used by the CUDACodeGen.
+    /// It only exists in m_FatbinFS, layered over the host's file system.
     const std::string m_FatbinFilePath;
 
+    ///\brief Serves the current fatbinary under m_FatbinFilePath.
+    llvm::IntrusiveRefCntPtr<CUDAFatbinFileSystem> m_FatbinFS;
+
+    ///\brief The NVPTX TargetMachine, created for the first input and reused.
+    std::unique_ptr<llvm::TargetMachine> m_TargetMachine;
+
     ///\brief Contains the PTX code of the current input
     llvm::SmallString<1024> m_PTX_code;
 
@@ -101,18 +113,24 @@ namespace cling {
         std::vector<std::string>& argv,
         const std::shared_ptr<clang::HeaderSearchOptions> &headerSearchOptions);
 
-    ///\brief Compiles a PTX file from the current input. The PTX code is
-    /// written to cling.ptx.
+    ///\brief Compiles the module of the last transaction of the PTX
+    /// interpreter to PTX code, stored in m_PTX_code.
     ///
-    ///\returns True, if the new cling.ptx was compiled.
-    bool generatePTX();
+    ///\returns True, if the PTX code was generated.
+    bool generatePTX(llvm::Module& module);
 
-    ///\brief Wrap up the ptx_code in the NVIDIA fatbinary format. The fatbin
-    /// code is written to m_FatbinFilePath.
+    ///\brief Wrap up the ptx_code in the NVIDIA fatbinary format and make it
+    /// the content of m_FatbinFilePath in m_FatbinFS.
     ///
-    ///\returns True, if the fatbinary tool returns 0.
+    ///\returns True, if the fatbinary was generated.
     bool generateFatbinary();
 
+    ///\brief Generate PTX and fatbinary for the last transaction of the PTX
+    /// interpreter. Inputs without device code keep the current fatbinary.
+    ///
+    ///\returns True, if the fatbinary is up to date.
+    bool updateFatbinary();
+
     ///\brief The function set the values of m_CuArgs.
     ///
     ///\param [in] langOpts - The LangOptions of the CompilerInstance.
@@ -141,14 +159,15 @@ namespace cling {
         const cling::InvocationOptions& invocationOptions,
         const clang::CompilerInstance& CI);
 
+    ~IncrementalCUDADeviceCompiler();
+
     ///\brief Returns a reference to the PTX interpreter
     ///
     ///\return std::unique_ptr< cling::Interpreter >&
     ///
     Interpreter *getPTXInterpreter() { return m_PTX_interp.get(); }
 
-    ///\brief Generate an new fatbin file with the path in
-    /// CudaGpuBinaryFileNames.
+    ///\brief Generate a new fatbinary for CudaGpuBinaryFileNames.
     ///
     /// This interface helps to run everything that the device compiler can run.
     /// Note that this should be used when there is no idea of what kind of
@@ -159,13 +178,12 @@ namespace cling {
     ///\param [in] input - The input directly from the UI. Attention, the string
     /// must not be wrapped or transformed.
     ///
-    ///\returns true, if all stages of generating fatbin runs right and a new
-    /// fatbin file is written.
+    ///\returns true, if all stages of generating fatbin runs right and the
+    /// fatbinary is up to date.
     bool process(const std::string& input);
 
-    ///\brief Generate an new fatbin file with the path in
-    /// CudaGpuBinaryFileNames from input line, which doesn't contain
-    /// statements.
+    ///\brief Generate a new fatbinary for CudaGpuBinaryFileNames from input
+    /// line, which doesn't contain statements.
     ///
     /// The interface circumvents the most of the extra work necessary to
     /// compile and run statements.
@@ -173,8 +191,8 @@ namespace cling {
     /// @param[in] input - The input containing only declarations (aka
     ///                    Top Level Declarations)
     ///
-    ///\returns true, if all stages of generating fatbin runs right and a new
-    /// fatbin file is written.
+    ///\returns true, if all stages of generating fatbin runs right and the
+    /// fatbinary is up to date.
     bool declare(const std::string& input);
 
     ///\brief Parses input line, which doesn't contain statements. No code
@@ -188,6 +206,13 @@ namespace cling {
     ///\returns true if parsing of the input was correct
     bool parse(const std::string& input) const;
 
+    ///\brief Returns the PTX code of the latest input with device code.
+    llvm::StringRef getPTX() const { return m_PTX_code; }
+
+    ///\brief Returns the fatbinary handed to the host CodeGen; empty until
+    /// the first input was compiled.
+    llvm::StringRef getFatbinary() const;
+
     ///\brief Print some information of the IncrementalCUDADeviceCompiler to
     /// llvm::outs().
     void dump();
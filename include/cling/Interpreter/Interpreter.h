@@ -22,6 +22,7 @@
 
 #include <cstdlib>
 #include <memory>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 
@@ -33,6 +34,7 @@ namespace llvm {
   class Module;
   class StringRef;
   class Type;
+  template <typename T> class ArrayRef;
   template <typename T> class SmallVectorImpl;
   namespace orc {
     class DefinitionGenerator;
@@ -83,6 +85,7 @@ namespace cling {
   class InterpreterCallbacks;
   class LookupHelper;
   class Transaction;
+  class TransactionUnloader;
   class Value;
 
   ///\brief Class that implements the interpreter-like behavior. It manages the
@@ -94,11 +97,33 @@ namespace cling {
      // include the actual definition of PresumedLoc.
      using IgnoreFilesFunc_t = bool (*)(const clang::PresumedLoc&);
 
+    ///\brief Locks the interpreter for the scope of the RAII object when
+    /// concurrent queries are enabled (see enableConcurrentQueries()).
+    ///
+    /// Queries that do not change the interpreter state take the lock shared,
+    /// everything else takes it exclusively. The lock is re-entrant per
+    /// thread: if the thread already holds it, only a shared lock that is
+    /// asked for exclusive access does something, namely release and
+    /// re-acquire the lock exclusively until the object goes out of scope.
+    /// Does nothing if concurrent queries are disabled.
+    class QueryLockRAII {
+    private:
+      const Interpreter* m_Interpreter = nullptr;
+      bool m_Exclusive = false;
+      bool m_Upgraded = false;
+    public:
+      QueryLockRAII(const Interpreter& I, bool Exclusive);
+      ~QueryLockRAII();
+      QueryLockRAII(const QueryLockRAII&) = delete;
+      QueryLockRAII& operator=(const QueryLockRAII&) = delete;
+    };
+
     ///\brief Pushes a new transaction, which will collect the decls that came
     /// within the scope of the RAII object. Calls commit transaction at
     /// destruction.
     class PushTransactionRAII {
     private:
+      QueryLockRAII m_Lock;
       Transaction* m_Transaction;
       const Interpreter* m_Interpreter;
     public:
@@ -116,6 +141,22 @@ namespace cling {
       ~StateDebuggerRAII();
     };
 
+    ///\brief A position in the transaction history of the interpreter, see
+    /// checkpoint() and restore().
+    ///
+    class Checkpoint {
+    private:
+      friend class Interpreter;
+      ///\brief The serial number of the last transaction when the
+      /// checkpoint was taken; transactions are recycled, so neither their
+      /// address nor their position tells whether it got unloaded since.
+      unsigned long long m_Serial = 0;
+      ///\brief Its position in the history.
+      size_t m_NumTransactions = 0;
+    public:
+      bool isValid() const { return m_Serial; }
+    };
+
     ///\brief Describes the return result of the different routines that do the
     /// incremental compilation.
     ///
@@ -250,6 +291,20 @@ namespace cling {
     };
     mutable const Transaction* m_CachedTrns[kNumTransactions] = {};
 
+    ///\brief The unloader of the batch currently being unloaded by
+    /// unloadTransactions(), if any.
+    ///
+    TransactionUnloader* m_BatchUnloader = nullptr;
+
+    ///\brief Serializes state changing calls against concurrent queries; see
+    /// enableConcurrentQueries().
+    ///
+    mutable std::shared_mutex m_QueryLock;
+
+    ///\brief Whether m_QueryLock is used.
+    ///
+    bool m_ConcurrentQueries = false;
+
     ///\brief Worker function, building block for interpreter's public
     /// interfaces.
     ///
@@ -331,6 +386,23 @@ namespace cling {
                                                 bool withAccessControl,
                                                 Transaction*& T);
 
+    ///\brief Drops the interpreter state referring to the transactions about
+    /// to be unloaded: stored states, cached transactions and static
+    /// destructors bound to them.
+    ///
+    void prepareUnload(llvm::ArrayRef<Transaction*> Ts);
+
+    ///\brief Reverts the declarations of a prepared transaction and removes
+    /// it from the transaction collection.
+    ///
+    void revertAndDeregister(Transaction& T, TransactionUnloader& U);
+
+    ///\brief Unloads several transactions, most recent first, with a single
+    /// JIT removal and source cache invalidation for all of them and their
+    /// nested transactions.
+    ///
+    void unloadTransactions(llvm::ArrayRef<Transaction*> Ts);
+
     ///\brief Initialize runtime and C/C++ level overrides
     ///
     ///\param[in] NoRuntime - Don't include the runtime headers / gCling
@@ -347,7 +419,7 @@ namespace cling {
     ///\brief The target constructor to be called from both the delegating
     /// constructors. parentInterp might be nullptr.
     ///
-    Interpreter(int argc, const char* const* argv, const char* llvmdir,
+    Interpreter(const InvocationOptions& Opts, const char* llvmdir,
                 const ModuleFileExtensions& moduleExtensions,
                 void *extraLibHandle, bool noRuntime,
                 const Interpreter* parentInterp);
@@ -364,7 +436,24 @@ namespace cling {
     Interpreter(int argc, const char* const* argv, const char* llvmdir = LLVM_PATH,
                 const ModuleFileExtensions& moduleExtensions = {},
                 void *extraLibHandle = nullptr, bool noRuntime = false)
-        : Interpreter(argc, argv, llvmdir, moduleExtensions, extraLibHandle,
+        : Interpreter(InvocationOptions(argc, argv), llvmdir, moduleExtensions,
+                      extraLibHandle, noRuntime, nullptr) {}
+
+    ///\brief Constructor for Interpreter from already parsed options, e.g.
+    /// when the caller needs to inspect them before setting up the
+    /// interpreter. Options point into the caller's argv and strings, which
+    /// need to outlive the Interpreter.
+    ///
+    ///\param[in] Opts - the parsed arguments.
+    ///\param[in] llvmdir - ???
+    ///\param[in] extraLibHandle - resolve symbols also from this dylib
+    ///\param[in] noRuntime - flag to control the presence of runtime universe
+    ///
+    Interpreter(const InvocationOptions& Opts,
+                const char* llvmdir = LLVM_PATH,
+                const ModuleFileExtensions& moduleExtensions = {},
+                void *extraLibHandle = nullptr, bool noRuntime = false)
+        : Interpreter(Opts, llvmdir, moduleExtensions, extraLibHandle,
                       noRuntime, nullptr) {}
 
     ///\brief Constructor for child Interpreter.
@@ -481,8 +570,10 @@ namespace cling {
 
     ///\brief Dump various internal data.
     ///
-    ///\param[in] what - which data to dump. 'undo', 'ast', 'asttree'
-    ///\param[in] filter - optional argument to filter data with.
+    ///\param[in] what - which data to dump. 'undo', 'ast', 'asttree', 'decl',
+    /// 'memory' or 'transformers'.
+    ///\param[in] filter - optional argument to filter data with; for 'memory'
+    /// the number of transactions to list.
     ///
     void dump(llvm::StringRef what, llvm::StringRef filter);
 
@@ -703,11 +794,32 @@ namespace cling {
 
     ///\brief Unloads (forgets) given number of transactions.
     ///
+    /// The transactions are torn down together: their JIT code is removed in
+    /// one go and the file caches are invalidated once.
+    ///
     ///\param[in] numberOfTransactions - how many transactions to revert
     ///                                  starting from the last.
     ///
     void unload(unsigned numberOfTransactions);
 
+    ///\brief Remembers the current position in the transaction history.
+    ///
+    Checkpoint checkpoint() const;
+
+    ///\brief Unloads everything that came after the checkpoint.
+    ///
+    /// All later transactions are torn down as one batch, like
+    /// unload(unsigned): their static destructors and atexit functions run,
+    /// their code leaves the JIT in one removal and the file caches are
+    /// invalidated once. Must not be called from code run by this
+    /// interpreter.
+    ///
+    ///\param[in] C - the checkpoint to go back to.
+    ///\returns false if the checkpoint itself was unloaded in the meantime
+    ///          or the later transactions could not all be unloaded.
+    ///
+    bool restore(const Checkpoint& C);
+
     void runAndRemoveStaticDestructors();
     void runAndRemoveStaticDestructors(unsigned numberOfTransactions);
 
@@ -720,6 +832,62 @@ namespace cling {
     bool isRawInputEnabled() const { return m_RawInputEnabled; }
     void enableRawInput(bool raw = true) { m_RawInputEnabled = raw; }
 
+    ///\brief Allows reflection queries from several threads while another
+    /// thread compiles.
+    ///
+    /// When enabled, the interpreter is guarded by a reader/writer lock:
+    /// getAddressOfGlobal(llvm::StringRef) and the findType() / findScope()
+    /// lookups of results that are already known take it shared and can run
+    /// in parallel; parsing, declaring, evaluating, loading, unloading and
+    /// every other lookup take it exclusively. User code run by evaluate()
+    /// and friends runs with the exclusive lock held, so it must not wait on
+    /// other threads using the same interpreter. Code accessing the clang or
+    /// llvm objects of the interpreter directly has to hold a
+    /// QueryLockRAII itself. As before, the returned declarations, types and
+    /// addresses are only valid until they are unloaded.
+    ///
+    /// Must be toggled while no other thread uses the interpreter.
+    ///
+    void enableConcurrentQueries(bool on = true) { m_ConcurrentQueries = on; }
+    bool isConcurrentQueriesEnabled() const { return m_ConcurrentQueries; }
+
+    ///\brief Instruments the code of the following inputs to count how often
+    /// its branches are taken, see reoptimizeWithProfile(). The counters live
+    /// in the JITted data; no profiling runtime is needed.
+    ///
+    void enableProfileInstrumentation(bool value = true);
+    bool isProfileInstrumentationEnabled() const;
+
+    ///\brief Re-optimizes instrumented functions using the counts collected
+    /// so far, which guide inlining and code layout. Their symbols resolve to
+    /// the re-optimized code from then on, e.g. for new inputs and
+    /// getAddressOfGlobal(); code linked before keeps calling the
+    /// instrumented version. Only functions that were executed are
+    /// re-optimized.
+    ///
+    ///\param[in] Function - The IR name of the function, or its demangled
+    ///   name with or without parameter list; all functions if empty.
+    ///\param[in] T - If set, only functions compiled with this transaction.
+    ///
+    ///\returns the number of re-optimized functions.
+    ///
+    unsigned reoptimizeWithProfile(llvm::StringRef Function = llvm::StringRef(),
+                                   const Transaction* T = nullptr);
+
+    ///\brief Writes the counts collected so far as indexed profile, to be
+    /// passed to `clang -fprofile-use` when the same code is compiled ahead of
+    /// time.
+    ///
+    ///\returns false if the file could not be written.
+    ///
+    bool writeProfile(llvm::StringRef FileName) const;
+
+    ///\brief Returns a counter that changes whenever transactions are
+    /// committed or unloaded, e.g. to tell whether cached lookup results are
+    /// still valid.
+    ///
+    unsigned long long getStateGeneration() const;
+
     unsigned getInputFlags() const { return m_InputFlags; }
     void setInputFlags(unsigned value) { m_InputFlags = value; }
 
@@ -865,6 +1033,21 @@ namespace cling {
     void GenerateAutoLoadingMap(llvm::StringRef inFile, llvm::StringRef outFile,
                                 bool enableMacros = false, bool enableLogs = true);
 
+    ///\brief Writes a binary autoload index of the names declared by inFiles,
+    /// to be memory-mapped with --autoload-index=outFile. Unlike the maps of
+    /// GenerateAutoLoadingMap() nothing has to be parsed at startup: names
+    /// are looked up in the index only once a lookup fails.
+    ///
+    ///\param[in] inFiles - the headers to index, as they would be #included.
+    ///\param[in] outFile - the index to write.
+    ///\param[in] library - the library defining the names, if any.
+    ///
+    ///\returns false if the index could not be written.
+    ///
+    bool GenerateAutoloadIndex(llvm::ArrayRef<std::string> inFiles,
+                               llvm::StringRef outFile,
+                               llvm::StringRef library = llvm::StringRef());
+
     void forwardDeclare(Transaction& T, clang::Preprocessor& P,
                         clang::ASTContext& Ctx,
                         llvm::raw_ostream& out,
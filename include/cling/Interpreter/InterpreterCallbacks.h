@@ -116,6 +116,12 @@ namespace cling {
 
     /// \brief This callback is invoked whenever the interpreter failed to load a library.
     ///
+    /// It is also invoked with the name of a symbol that is unresolved while
+    /// linking. If it returns false and no library provides the symbol, it is
+    /// not asked about that symbol again until the generation of the
+    /// DynamicLibraryManager changes, i.e. until a library or a search path
+    /// gets added or removed.
+    ///
     /// \param[in] - Error message and parameters passed to loadLibrary
     /// \returns true if the error was handled.
     virtual bool LibraryLoadingFailed(const std::string&, const std::string&, bool, bool) { return 0; }
@@ -154,6 +160,15 @@ namespace cling {
     ///
     virtual void TransactionRollback(const Transaction&) {}
 
+    ///\brief This callback is invoked once the memory caused by a transaction
+    /// has been accounted, right before it is reported as committed. JIT
+    /// sections emitted later are added to Transaction::getMemoryUsage()
+    /// without another notification.
+    ///
+    ///\param[in] - The transaction whose memory usage was recorded.
+    ///
+    virtual void TransactionMemoryAccounted(const Transaction&) {}
+
     /// \brief This callback is invoked if a previous definition has been shadowed.
     ///
     ///\param[in] - The declaration that has been shadowed.
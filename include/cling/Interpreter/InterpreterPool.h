@@ -0,0 +1,135 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CLING - the C++ LLVM-based InterpreterG :)
+//
+// This file is dual-licensed: you can choose to license it under the University
+// of Illinois Open Source License or the GNU Lesser General Public License. See
+// LICENSE.TXT for details.
+//------------------------------------------------------------------------------
+
+#ifndef CLING_INTERPRETER_POOL_H
+#define CLING_INTERPRETER_POOL_H
+
+#include "cling/Interpreter/Interpreter.h"
+
+#include "llvm/ADT/StringRef.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cling {
+  ///\brief A set of pre-warmed child interpreters of one parent, handed out
+  /// to worker threads.
+  ///
+  /// The children see the declarations and the JITted symbols of the parent
+  /// (see ExternalInterpreterSource), but declare into their own AST and JIT.
+  /// When a Lease ends, everything the child got since its set up is
+  /// unloaded again, so the next user finds it as fresh as a new child
+  /// without paying for its construction.
+  ///
+  /// A child is used by one thread at a time. The parent can keep serving
+  /// other threads: the pool enables its concurrent queries, and the children
+  /// lock it while they import from it. Code still has to be declared into
+  /// the parent before the children look it up.
+  ///
+  class InterpreterPool {
+  private:
+    struct Entry {
+      std::unique_ptr<Interpreter> Interp;
+      ///\brief The state of the child after its set up, to roll back to.
+      Interpreter::Checkpoint Checkpoint;
+    };
+
+  public:
+    ///\brief Access to one child interpreter of the pool; returns the child
+    /// to the pool on destruction.
+    ///
+    class Lease {
+    private:
+      InterpreterPool* m_Pool = nullptr;
+      std::unique_ptr<Entry> m_Entry;
+
+      friend class InterpreterPool;
+      Lease(InterpreterPool& Pool, std::unique_ptr<Entry> E)
+        : m_Pool(&Pool), m_Entry(std::move(E)) {}
+
+    public:
+      Lease() = default;
+      Lease(Lease&& Other) = default;
+      Lease& operator=(Lease&& Other);
+      ~Lease() { release(); }
+
+      ///\brief Rolls the child back and returns it to the pool. Values and
+      /// addresses obtained from the child are invalid afterwards.
+      void release();
+
+      Interpreter* get() const {
+        return m_Entry ? m_Entry->Interp.get() : nullptr;
+      }
+      Interpreter& operator*() const { return *get(); }
+      Interpreter* operator->() const { return get(); }
+      explicit operator bool() const { return get(); }
+    };
+
+    ///\brief Creates Size children of Parent.
+    ///
+    ///\param[in] Parent - the interpreter the children import from. Must
+    ///           outlive the pool.
+    ///\param[in] Size - the number of children.
+    ///\param[in] argc, argv, llvmdir - as for the child Interpreter.
+    ///\param[in] Prologue - code declared into every child before its
+    ///           checkpoint is taken, i.e. kept across leases.
+    ///
+    /// Enables the concurrent queries of Parent, so no other thread may use
+    /// Parent while the pool is constructed.
+    ///
+    InterpreterPool(Interpreter& Parent, unsigned Size, int argc,
+                    const char* const* argv, const char* llvmdir = LLVM_PATH,
+                    llvm::StringRef Prologue = llvm::StringRef());
+    ~InterpreterPool();
+
+    InterpreterPool(const InterpreterPool&) = delete;
+    InterpreterPool& operator=(const InterpreterPool&) = delete;
+
+    ///\brief Waits until a child is free and leases it.
+    ///
+    Lease acquire();
+
+    ///\brief Leases a free child; returns an empty Lease if there is none.
+    ///
+    Lease tryAcquire();
+
+    unsigned size() const { return m_Size; }
+
+    ///\brief The number of children that are not leased.
+    ///
+    unsigned available() const;
+
+  private:
+    Interpreter& m_Parent;
+    unsigned m_Size;
+    std::string m_LLVMDir;
+    bool m_HasLLVMDir;
+    std::vector<std::string> m_Args;
+    std::string m_Prologue;
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Returned;
+    std::vector<std::unique_ptr<Entry>> m_Free;
+
+    ///\brief Creates a child and takes its checkpoint.
+    ///
+    std::unique_ptr<Entry> createChild() const;
+
+    ///\brief Unloads what E's child got since its checkpoint; recreates the
+    /// child if the checkpoint itself is gone.
+    ///
+    void rollback(Entry& E) const;
+
+    void giveBack(std::unique_ptr<Entry> E);
+  };
+} // end namespace cling
+
+#endif // CLING_INTERPRETER_POOL_H
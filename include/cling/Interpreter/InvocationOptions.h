@@ -92,12 +92,20 @@ namespace cling {
     std::vector<std::string> Inputs;
     CompilerOptions CompilerOpts;
 
+    /// \brief If not empty, the directory in which the PCHs built from the
+    ///        leading #includes of the startup macros are cached.
+    std::string PreambleCachePath;
+
+    /// \brief Binary autoload indexes to memory-map at startup.
+    std::vector<std::string> AutoloadIndexes;
+
     unsigned ErrorOut : 1;
     unsigned NoLogo : 1;
     unsigned ShowVersion : 1;
     unsigned Help : 1;
     unsigned NoRuntime : 1;
     unsigned PtrCheck : 1; /// Enable NullDerefProtectionTransformer
+    unsigned RuntimePCH : 1; /// Load the prebuilt runtime PCH if compatible
     bool Verbose() const { return CompilerOpts.Verbose; }
 
     static void PrintHelp();
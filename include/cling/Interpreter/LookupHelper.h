@@ -10,6 +10,7 @@
 #ifndef CLING_LOOKUP_HELPER_H
 #define CLING_LOOKUP_HELPER_H
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/SmallVector.h"
 
@@ -74,6 +75,33 @@ namespace cling {
     /// If we are called recursively.
     bool IsRecursivelyRunning = false;
 
+    /// A successful findType() or findScope() result.
+    struct QueryCacheEntry {
+      /// The QualType's opaque pointer or the Decl.
+      const void* Result;
+      /// The resultType of findScope().
+      const clang::Type* Type;
+    };
+    /// The findType() and findScope() results by query, used while the
+    /// interpreter allows concurrent queries. Hits are looked up under the
+    /// shared lock, so that concurrent readers do not need to parse; entries
+    /// are only added under the exclusive lock and are stale as soon as the
+    /// interpreter's state generation changes.
+    mutable llvm::StringMap<QueryCacheEntry> m_QueryCache;
+    /// Interpreter::getStateGeneration() the m_QueryCache entries belong to.
+    mutable unsigned long long m_QueryCacheGeneration = 0;
+
+    bool findCachedQuery(llvm::StringRef Key, QueryCacheEntry& Entry) const;
+    void cacheQuery(llvm::StringRef Key, const void* Result,
+                    const clang::Type* Type) const;
+
+    clang::QualType findTypeImpl(llvm::StringRef typeName,
+                                 DiagSetting diagOnOff) const;
+    const clang::Decl* findScopeImpl(llvm::StringRef className,
+                                     DiagSetting diagOnOff,
+                                     const clang::Type** resultType,
+                                     bool instantiateTemplate) const;
+
   public:
     LookupHelper(clang::Parser* P, Interpreter* interp);
     ~LookupHelper();
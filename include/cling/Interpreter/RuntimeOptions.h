@@ -14,11 +14,16 @@ namespace cling {
     /// \brief Interpreter configuration bits that can be changed at run-time
     /// by the user, e.g. to enable/disable extensions.
     struct RuntimeOptions {
-      RuntimeOptions() : AllowRedefinition(0) {}
+      RuntimeOptions() : AllowRedefinition(0), BorrowResults(0) {}
 
       /// \brief Allow the user to redefine entities (requests enabling the
       /// `DefinitionShadower` AST transformer).
       bool AllowRedefinition : 1;
+
+      /// \brief Let the results of expressions naming a variable with static
+      /// storage, e.g. a global array, refer to the variable instead of
+      /// holding a copy of it.
+      bool BorrowResults : 1;
     };
 
   } // end namespace runtime
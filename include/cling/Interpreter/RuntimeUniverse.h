@@ -167,12 +167,19 @@ namespace cling {
       /// must be consistent with what clang does, since it is not well defined
       /// in the C++ standard.
       ///
+      /// Trivially copyable elements are copied in one go; their copy has no
+      /// observable per-element side effect.
+      ///
       ///\param[in] src - array to copy
       ///\param[in] placement - where to copy
       ///\param[in] size - size of the array.
       ///
       template <class T>
       void copyArray(T* src, void* placement, std::size_t size) {
+        if (__is_trivially_copyable(T)) {
+          __builtin_memcpy(placement, (const void*)src, size * sizeof(T));
+          return;
+        }
         for (std::size_t i = 0; i < size; ++i)
           new ((void*)(((T*)placement) + i)) T(src[i]);
       }
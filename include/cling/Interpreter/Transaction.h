@@ -113,7 +113,10 @@ namespace cling {
   private:
     // Intentionally use struct instead of pair because we don't need default
     // init.
-    typedef llvm::SmallVector<DelayCallInfo, 64> DeclQueue;
+    // Most transactions, in particular the nested ones opened for template
+    // instantiation, deserialization and codegen, see a handful of decl groups
+    // at most; larger ones grow their queues out of line.
+    typedef llvm::SmallVector<DelayCallInfo, 4> DeclQueue;
     typedef llvm::SmallVector<Transaction*, 2> NestedTransactions;
 
     ///\brief All seen declarations, except the deserialized ones.
@@ -179,6 +182,12 @@ namespace cling {
     ///
     const Transaction* m_Next;
 
+    ///\brief Position of the transaction in the history of its interpreter,
+    /// increasing with every transaction added to it; 0 if not added yet.
+    /// Unlike the pointer, it is not reused when the transaction is recycled.
+    ///
+    unsigned long long m_Serial;
+
     ///\brief The Sema holding the ASTContext and the Preprocessor.
     ///
     clang::Sema& m_Sema;
@@ -197,6 +206,35 @@ namespace cling {
     ///
     clang::FileID m_BufferFID;
 
+  public:
+    ///\brief Memory caused by a transaction, in bytes.
+    ///
+    struct MemoryUsage {
+      ///\brief Growth of the ASTContext allocators, including nested
+      /// transactions.
+      size_t AST = 0;
+      ///\brief Growth of the SourceManager's buffers and tables.
+      size_t SourceManager = 0;
+      ///\brief Estimated size of the llvm::Module, which the JIT keeps alive
+      /// until the transaction is unloaded.
+      size_t Module = 0;
+      ///\brief Code and data sections emitted by the JIT; these are added
+      /// once the module is materialized, which might be after the commit.
+      size_t JITCode = 0;
+      size_t JITData = 0;
+      ///\brief Bookkeeping of the atexit functions registered by the code.
+      size_t AtExit = 0;
+
+      size_t total() const {
+        return AST + SourceManager + Module + JITCode + JITData + AtExit;
+      }
+    };
+
+  private:
+    ///\brief Memory attributed to this transaction.
+    ///
+    MemoryUsage m_MemoryUsage;
+
     /// TransactionPool needs direct access to m_State as setState asserts
     friend class TransactionPool;
     friend class IncrementalJIT;
@@ -500,6 +538,12 @@ namespace cling {
     const Transaction* getNext() const { return m_Next; }
     void setNext(Transaction* T) { m_Next = T; }
 
+    unsigned long long getSerial() const { return m_Serial; }
+    void setSerial(unsigned long long S) { m_Serial = S; }
+
+    const MemoryUsage& getMemoryUsage() const { return m_MemoryUsage; }
+    MemoryUsage& getMemoryUsage() { return m_MemoryUsage; }
+
     void setBufferFID(clang::FileID FID) { m_BufferFID = FID; }
     clang::FileID getBufferFID() const { return m_BufferFID; }
     clang::SourceLocation getSourceStart(const clang::SourceManager& SM) const;
@@ -10,6 +10,9 @@
 #ifndef CLING_DISPLAY_H
 #define CLING_DISPLAY_H
 
+#include "llvm/ADT/StringRef.h"
+
+#include <cstddef>
 #include <string>
 
 namespace llvm {
@@ -19,17 +22,42 @@ namespace llvm {
 namespace cling {
 class Interpreter;
 
+///\brief Selects and pages the entries listed by .class, .g and .typedef.
+///
+/// Written as "[scope::]pattern [first][:count]", where pattern is a name
+/// with '*' and '?' wildcards or a regular expression enclosed in '/'. A
+/// filtered listing only deserializes the declarations it matches.
+///
+struct DisplayFilter {
+  std::string Scope;
+  std::string Pattern;
+  bool IsRegex = false;
+  size_t First = 0;
+  size_t Count = 0; ///< 0 means no limit.
+
+  ///\brief Returns true and fills filter if arg is a filter rather than a
+  /// plain name.
+  ///
+  static bool parse(llvm::StringRef arg, DisplayFilter &filter);
+};
+
 void DisplayClass(llvm::raw_ostream &stream,
                   const Interpreter *interpreter, const char *className,
                   bool verbose);
+void DisplayClasses(llvm::raw_ostream &stream, const Interpreter *interpreter,
+                    const DisplayFilter &filter, bool verbose);
 
 void DisplayNamespaces(llvm::raw_ostream &stream, const Interpreter *interpreter);
 
 void DisplayGlobals(llvm::raw_ostream &stream, const Interpreter *interpreter);
+void DisplayGlobals(llvm::raw_ostream &stream, const Interpreter *interpreter,
+                    const DisplayFilter &filter);
 void DisplayGlobal(llvm::raw_ostream &stream, const Interpreter *interpreter,
                    const std::string &name);
 
 void DisplayTypedefs(llvm::raw_ostream &stream, const Interpreter *interpreter);
+void DisplayTypedefs(llvm::raw_ostream &stream, const Interpreter *interpreter,
+                     const DisplayFilter &filter);
 void DisplayTypedef(llvm::raw_ostream &stream, const Interpreter *interpreter,
                     const std::string &name);
 
@@ -32,7 +32,8 @@ namespace cling {
   ///                            PrintDebugCommand | DynamicExtensionsCommand |
   ///                            HelpCommand | FileExCommand | FilesCommand |
   ///                            ClassCommand | GCommand | StoreStateCommand |
-  ///                            CompareStateCommand | StatsCommand | undoCommand
+  ///                            CompareStateCommand | StatsCommand | undoCommand |
+  ///                            pgoCommand
   ///                 LCommand := 'L' [FilePath]
   ///                 TCommand := 'T' FilePath FilePath
   ///                 >Command := '>' FilePath
@@ -50,6 +51,9 @@ namespace cling {
   ///                 traceCommand := 'trace' ['ast'] ["Ident"]
   ///                 undoCommand := 'undo' [Constant]
   ///                 DynamicExtensionsCommand := 'dynamicExtensions' [Constant]
+  ///                 pgoCommand := 'pgo' [Constant] |
+  ///                               'pgo' 'optimize' [AnyString] |
+  ///                               'pgo' 'write' FilePath
   ///                 HelpCommand := 'help'
   ///                 FileExCommand := 'fileEx'
   ///                 FilesCommand := 'files'
@@ -102,6 +106,7 @@ namespace cling {
     bool isstatsCommand();
     bool istraceCommand();
     bool isundoCommand();
+    bool ispgoCommand(MetaSema::ActionResult& actionResult);
     bool isdynamicExtensionsCommand();
     bool ishelpCommand();
     bool isfileExCommand();
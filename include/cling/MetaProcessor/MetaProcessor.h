@@ -57,6 +57,15 @@ namespace cling {
     ///
     llvm::raw_ostream* m_Outs;
 
+    ///\brief Files of at least this size are processed by readInputFromFile()
+    /// in chunks, each compiled and run before the next one is parsed.
+    ///
+    size_t m_ChunkThreshold;
+
+    ///\brief Approximate size of these chunks.
+    ///
+    size_t m_ChunkSize;
+
     ///\brief Internal class to store redirection state.
     ///
     class RedirectOutput;
@@ -148,6 +157,18 @@ namespace cling {
                       size_t posOpenCurly = (size_t)(-1),
                       bool lineByLine = false);
 
+    ///\brief Set the size from which readInputFromFile() splits a file into
+    /// chunks at top-level statement boundaries and processes them one at a
+    /// time, bounding the memory needed for huge generated files. Pass
+    /// (size_t)-1 to always process files as a whole. Both the threshold and
+    /// the chunk size default to CLING_FILE_CHUNK_SIZE if set.
+    ///
+    void setChunkThreshold(size_t bytes) { m_ChunkThreshold = bytes; }
+
+    ///\brief Set the approximate size of these chunks.
+    ///
+    void setChunkSize(size_t bytes) { m_ChunkSize = bytes; }
+
     ///\brief Set the stdout and stderr stream to the appropriate file.
     ///
     ///\param [in] file - The file for the redirection.
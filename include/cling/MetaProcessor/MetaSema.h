@@ -188,6 +188,25 @@ namespace cling {
     ///
     void actOndynamicExtensionsCommand(SwitchMode mode = kToggle) const;
 
+    ///\brief Switches on/off the profile instrumentation of new inputs.
+    ///
+    ///\param[in] mode - either on/off or toggle.
+    ///
+    void actOnpgoCommand(SwitchMode mode = kToggle) const;
+
+    ///\brief Re-optimizes instrumented functions with the counts collected
+    /// so far.
+    ///
+    ///\param[in] function - The function to re-optimize; all if empty.
+    ///
+    ActionResult actOnpgoOptimizeCommand(llvm::StringRef function) const;
+
+    ///\brief Writes the counts collected so far as .profdata file.
+    ///
+    ///\param[in] file - The file to write.
+    ///
+    ActionResult actOnpgoWriteCommand(llvm::StringRef file) const;
+
     ///\brief Prints out the help message with the description of the meta
     /// commands.
     ///
@@ -10,10 +10,14 @@
 #ifndef CLING_UTILS_AST_H
 #define CLING_UTILS_AST_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 
+#include <string>
+#include <vector>
+
 namespace clang {
   class ASTContext;
   class Expr;
@@ -174,6 +178,9 @@ namespace utils {
     ///\param[in] fullyQualify - if true insert Elaborated where needed.
     ///\returns Partially desugared QualType
     ///
+    /// The result is memoized per (QT, TypeConfig contents, fullyQualify);
+    /// see TypeName::InvalidateCache().
+    ///
     clang::QualType
     GetPartiallyDesugaredType(const clang::ASTContext& Ctx, clang::QualType QT,
                               const Config& TypeConfig,
@@ -312,6 +319,25 @@ namespace utils {
     std::string GetFullyQualifiedName(clang::QualType QT,
                                       const clang::ASTContext &Ctx);
 
+    ///\brief Get the fully qualified names of several types. Parts shared
+    /// between the types (scopes, template arguments) are normalized once.
+    ///
+    ///\param[in] QTs - the types for which the names will be returned.
+    ///\param[in] Ctx - the ASTContext to be used.
+    ///\param[out] Names - the names, in the order of QTs.
+    void GetFullyQualifiedNames(llvm::ArrayRef<clang::QualType> QTs,
+                                const clang::ASTContext& Ctx,
+                                std::vector<std::string>& Names);
+
+    ///\brief Forget the results of GetFullyQualifiedType(),
+    /// GetFullyQualifiedName() and Transform::GetPartiallyDesugaredType()
+    /// memoized for Ctx; needed once declarations they might refer to are
+    /// unloaded. As the computations themselves, the caches are not
+    /// thread-safe: callers must serialize access to Ctx.
+    ///
+    ///\param[in] Ctx - the ASTContext whose results should be dropped.
+    void InvalidateCache(const clang::ASTContext& Ctx);
+
     ///\brief Create a NestedNameSpecifier for Namesp and its enclosing
     /// scopes.
     ///
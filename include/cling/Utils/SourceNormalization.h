@@ -48,6 +48,24 @@ namespace utils {
   /// \return The position where the function signature and '{' should be
   ///     inserted; std::string::npos if this source should not be wrapped.
   size_t getWrapPoint(std::string& source, const clang::LangOptions& LangOpts);
+
+  ///\brief Find where to end a chunk of at least minSize characters such that
+  /// it can be processed independently of the text following it.
+  ///
+  /// Chunks end after a ';' or '}' at top level, outside of preprocessor
+  /// conditionals and only if the next token starts a new line that cannot
+  /// continue the previous statement (e.g. 'else').
+  ///
+  /// \param source - The source code to split; must be followed by a NUL
+  ///        character, like the contents of a MemoryBuffer.
+  /// \param begin - The offset in source where the chunk starts.
+  /// \param end - The offset in source where the chunk must end at the latest.
+  /// \param minSize - The minimal length of the chunk.
+  /// \param LangOpts - LangOptions to use for lexing.
+  /// \return The offset in source where the chunk ends; end if the text up
+  ///     to end cannot be split after minSize characters.
+  size_t getChunkEnd(llvm::StringRef source, size_t begin, size_t end,
+                     size_t minSize, const clang::LangOptions& LangOpts);
 } // namespace utils
 } // namespace cling
 
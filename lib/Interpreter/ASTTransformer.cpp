@@ -11,6 +11,55 @@
 
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/DeclGroup.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+
+#include "llvm/ADT/SmallVector.h"
+
+using namespace clang;
+
+namespace {
+  using namespace cling;
+
+  ///\brief Walks a declaration once, reporting the nodes to all transformers
+  /// that asked for them.
+  class SharedWalker : public RecursiveASTVisitor<SharedWalker> {
+    typedef RecursiveASTVisitor<SharedWalker> Base;
+    llvm::ArrayRef<ASTTransformer*> m_Transformers;
+    ///\brief Bit I is set if m_Transformers[I] wants the current nodes.
+    uint64_t m_Active;
+
+  public:
+    SharedWalker(llvm::ArrayRef<ASTTransformer*> Transformers,
+                 uint64_t Active)
+      : m_Transformers(Transformers), m_Active(Active) {}
+
+    bool TraverseDecl(Decl* D) {
+      FunctionDecl* FD = dyn_cast_or_null<FunctionDecl>(D);
+      if (!FD)
+        return Base::TraverseDecl(D);
+
+      uint64_t Outer = m_Active, Inner = 0;
+      for (size_t I = 0, N = m_Transformers.size(); I < N; ++I)
+        if ((Outer & (uint64_t(1) << I))
+            && m_Transformers[I]->enterFunction(FD))
+          Inner |= uint64_t(1) << I;
+      if (!Inner)
+        return true;
+
+      m_Active = Inner;
+      bool Continue = Base::TraverseDecl(D);
+      m_Active = Outer;
+      return Continue;
+    }
+
+    bool VisitStmt(Stmt* S) {
+      for (size_t I = 0, N = m_Transformers.size(); I < N; ++I)
+        if (m_Active & (uint64_t(1) << I))
+          m_Transformers[I]->visitStmt(S);
+      return true;
+    }
+  };
+} // unnamed namespace
 
 namespace cling {
 
@@ -22,4 +71,48 @@ namespace cling {
     m_Consumer->HandleTopLevelDecl(DGR);
   }
 
+  ASTTransformer::Result ASTTransformer::Transform(clang::Decl* D) {
+    assert(usesSharedWalk() && "Transformer must override Transform()");
+    ASTTransformer* Self[] = {this};
+    std::chrono::steady_clock::duration WalkTime{};
+    return walk(D, getTransaction(), Self, WalkTime);
+  }
+
+  ASTTransformer::Result
+  ASTTransformer::walk(clang::Decl* D, Transaction* T,
+                       llvm::ArrayRef<ASTTransformer*> Transformers,
+                       std::chrono::steady_clock::duration& WalkTime) {
+    assert(Transformers.size() <= 64 && "Too many transformers for one walk");
+    typedef std::chrono::steady_clock Clock;
+
+    uint64_t Active = 0;
+    for (size_t I = 0, N = Transformers.size(); I < N; ++I) {
+      ASTTransformer* TT = Transformers[I];
+      assert(TT->usesSharedWalk() && "Transformer walks on its own");
+      TT->m_Transaction = T;
+      Clock::time_point Start = Clock::now();
+      if (TT->beginWalk(D))
+        Active |= uint64_t(1) << I;
+      TT->countDecl(Clock::now() - Start);
+    }
+    if (!Active)
+      return Result(D, true);
+
+    Clock::time_point Start = Clock::now();
+    SharedWalker(Transformers, Active).TraverseDecl(D);
+    WalkTime += Clock::now() - Start;
+
+    for (size_t I = 0, N = Transformers.size(); D && I < N; ++I) {
+      if (!(Active & (uint64_t(1) << I)))
+        continue;
+      Start = Clock::now();
+      Result R = Transformers[I]->endWalk(D);
+      Transformers[I]->m_Stats.Time += Clock::now() - Start;
+      if (!R.getInt())
+        return R;
+      D = R.getPointer();
+    }
+    return Result(D, true);
+  }
+
 } // end namespace cling
@@ -10,6 +10,7 @@
 #ifndef CLING_AST_TRANSFORMER_H
 #define CLING_AST_TRANSFORMER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/PointerIntPair.h"
 
 #include "clang/AST/Decl.h" // for Result(Decl)
@@ -17,11 +18,15 @@
 
 #include "cling/Interpreter/Transaction.h"
 
+#include <chrono>
+
 namespace clang {
   class ASTConsumer;
   class Decl;
   class DeclGroupRef;
+  class FunctionDecl;
   class Sema;
+  class Stmt;
 }
 
 namespace cling {
@@ -41,6 +46,18 @@ namespace cling {
 
   public:
     typedef llvm::PointerIntPair<clang::Decl*, 1, bool> Result;
+
+    ///\brief Number of declarations handled and time spent doing so.
+    ///
+    struct Stats {
+      unsigned Decls = 0;
+      std::chrono::steady_clock::duration Time{};
+    };
+
+  private:
+    Stats m_Stats;
+
+  public:
     ///\brief Initializes a new transaction transformer.
     ///
     ///\param[in] S - The semantic analysis object.
@@ -95,7 +112,74 @@ namespace cling {
     ///
     Result Transform(clang::Decl* D, Transaction* T) {
       m_Transaction = T;
-      return Transform(D);
+      if (usesSharedWalk())
+        return Transform(D); // Counted by walk().
+      auto Start = std::chrono::steady_clock::now();
+      Result R = Transform(D);
+      countDecl(std::chrono::steady_clock::now() - Start);
+      return R;
+    }
+
+    ///\brief Whether the transformer has anything to do for a transaction
+    /// compiled with CO. Transformers that do not are skipped up front.
+    ///
+    virtual bool isEnabled(const CompilationOptions& CO) const { return true; }
+
+    ///\brief The name of the transformer in statistics.
+    ///
+    virtual const char* getName() const = 0;
+
+    const Stats& getStats() const { return m_Stats; }
+
+    ///\name Shared walk
+    /// Transformers that only need to look at and patch the statements of
+    /// the declarations override these hooks instead of walking the AST in
+    /// Transform(): consecutive such transformers then share one walk of
+    /// each declaration, see walk().
+    ///\{
+
+    ///\brief Whether the transformer takes part in the shared walk.
+    ///
+    virtual bool usesSharedWalk() const { return false; }
+
+    ///\brief Whether the walk of D should be reported to this transformer.
+    ///
+    virtual bool beginWalk(clang::Decl* D) { return false; }
+
+    ///\brief Whether the nodes of FD, found while walking, should be
+    /// reported. If no transformer wants them, FD is not walked at all.
+    ///
+    virtual bool enterFunction(clang::FunctionDecl* FD) { return true; }
+
+    ///\brief Reports a statement or expression, before its children. The
+    /// children may be replaced; the walk continues with the new ones.
+    ///
+    virtual void visitStmt(clang::Stmt* S) {}
+
+    ///\brief Called after the walk of D if beginWalk() returned true.
+    ///\returns The transformation result, as for Transform().
+    ///
+    virtual Result endWalk(clang::Decl* D) { return Result(D, true); }
+
+    ///\}
+
+    ///\brief Walks D once for all of Transformers, which use the shared walk.
+    ///
+    ///\param[in] D - The declaration to be transformed.
+    ///\param[in] T - The declaration's transaction.
+    ///\param[in] Transformers - The transformers, in order.
+    ///\param[out] WalkTime - Time spent walking, including the visitStmt()
+    ///   calls; beginWalk() and endWalk() count for their transformer.
+    ///\returns The transformation result, as for Transform().
+    ///
+    static Result walk(clang::Decl* D, Transaction* T,
+                       llvm::ArrayRef<ASTTransformer*> Transformers,
+                       std::chrono::steady_clock::duration& WalkTime);
+
+  protected:
+    void countDecl(std::chrono::steady_clock::duration Time) {
+      ++m_Stats.Decls;
+      m_Stats.Time += Time;
     }
 
   protected:
@@ -108,7 +192,10 @@ namespace cling {
     ///  if this declaration should not be emitted. Returning error will abort
     ///  the transaction.
     ///
-    virtual Result Transform(clang::Decl* D) = 0;
+    /// Transformers using the shared walk get the same result by walking D
+    /// just for themselves.
+    ///
+    virtual Result Transform(clang::Decl* D);
 
   };
 
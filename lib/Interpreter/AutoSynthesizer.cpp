@@ -106,7 +106,25 @@ namespace cling {
   AutoSynthesizer::~AutoSynthesizer()
   { }
 
-  ASTTransformer::Result AutoSynthesizer::Transform(Decl* D) {
+  bool AutoSynthesizer::beginWalk(Decl* D) {
+    m_FoundAuto = false;
+    return isa<FunctionDecl>(D);
+  }
+
+  void AutoSynthesizer::visitStmt(Stmt* S) {
+    if (m_FoundAuto)
+      return;
+    if (DeclRefExpr* DRE = dyn_cast<DeclRefExpr>(S))
+      if (const AnnotateAttr* A = DRE->getDecl()->getAttr<AnnotateAttr>())
+        m_FoundAuto = A->getAnnotation().equals("__Auto");
+  }
+
+  ASTTransformer::Result AutoSynthesizer::endWalk(Decl* D) {
+    // Only the rare bodies using auto declarations are searched statement by
+    // statement; this happens after the other transformers of the shared
+    // walk have seen the body.
+    if (!m_FoundAuto)
+      return Result(D, true);
     if (FunctionDecl* FD = dyn_cast<FunctionDecl>(D)) {
       // getBody() might return nullptr even though hasBody() is true for
       // late template parsed functions. We simply don't do auto auto on
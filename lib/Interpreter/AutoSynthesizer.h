@@ -17,6 +17,7 @@
 namespace clang {
   class Decl;
   class Sema;
+  class Stmt;
 }
 
 namespace cling {
@@ -26,6 +27,9 @@ namespace cling {
   private:
     std::unique_ptr<AutoFixer> m_AutoFixer;
 
+    ///\brief Whether the walked function refers to an auto declaration.
+    bool m_FoundAuto = false;
+
   public:
     ///\ brief Constructs the auto synthesizer.
     ///
@@ -35,7 +39,11 @@ namespace cling {
 
     virtual ~AutoSynthesizer();
 
-    Result Transform(clang::Decl*) override;
+    const char* getName() const override { return "AutoSynthesizer"; }
+    bool usesSharedWalk() const override { return true; }
+    bool beginWalk(clang::Decl* D) override;
+    void visitStmt(clang::Stmt* S) override;
+    Result endWalk(clang::Decl* D) override;
   };
 
 } // namespace cling
@@ -19,12 +19,16 @@
 #include "clang/AST/DeclVisitor.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Sema/Lookup.h"
+#include "clang/Sema/Scope.h"
 
 #include "cling/Interpreter/Interpreter.h"
 #include "cling/Interpreter/InterpreterCallbacks.h"
 #include "cling/Interpreter/AutoloadCallback.h"
+#include "cling/Interpreter/DynamicLibraryManager.h"
 #include "cling/Interpreter/Transaction.h"
 #include "cling/Utils/Output.h"
+#include "AutoloadIndex.h"
 #include "DeclUnloader.h"
 
 
@@ -42,6 +46,13 @@ namespace cling {
 
   void AutoloadCallback::report(clang::SourceLocation l, llvm::StringRef name,
                                 llvm::StringRef header) {
+    if (header.starts_with(llvm::StringRef(annoTag, lenAnnoTag)))
+      reportHeader(l, name, header.drop_front(lenAnnoTag));
+  }
+
+  void AutoloadCallback::reportHeader(clang::SourceLocation l,
+                                      llvm::StringRef name,
+                                      llvm::StringRef header) {
     Sema& sema= m_Interpreter->getSema();
 
     unsigned id
@@ -51,9 +62,86 @@ namespace cling {
       = sema.getDiagnostics().getCustomDiagID(DiagnosticsEngine::Level::Note,
                                                 "Type : %0 , Full Path: %1")*/;
 
-    if (header.starts_with(llvm::StringRef(annoTag, lenAnnoTag)))
-      sema.Diags.Report(l, id) << name << header.drop_front(lenAnnoTag);
+    sema.Diags.Report(l, id) << name << header;
+  }
+
+  bool AutoloadCallback::LookupObject(LookupResult& R, Scope* S) {
+    if (m_Indexes.empty() || !m_ShowSuggestions || R.isForRedeclaration())
+      return false;
+
+    const IdentifierInfo* II = R.getLookupName().getAsIdentifierInfo();
+    if (!II)
+      return false;
+
+    // Try the name in each enclosing namespace, innermost first, as the
+    // failed unqualified lookup would have.
+    DeclContext* DC = nullptr;
+    for (Scope* Cur = S; Cur && !DC; Cur = Cur->getParent())
+      DC = Cur->getEntity();
+    if (!DC)
+      DC = m_Interpreter->getSema().CurContext;
+
+    // Names in loops and dynamic scopes fail again and again.
+    const auto Key = std::make_pair(const_cast<const DeclContext*>(DC), II);
+    if (m_NotInIndexes.count(Key))
+      return false;
+
+    llvm::StringRef Header, Library;
+    bool Found = false;
+    for (; DC && !Found; DC = DC->getParent()) {
+      std::string Name;
+      if (auto NSD = dyn_cast<NamespaceDecl>(DC))
+        Name = NSD->getQualifiedNameAsString() + "::";
+      else if (!DC->isTranslationUnit())
+        continue;
+      Name += II->getName();
+      if (lookupIndex(Name, Header, Library)) {
+        if (m_ReportedNames.insert(Name).second)
+          reportHeader(R.getNameLoc(), Name, Header);
+        Found = true;
+      }
+    }
+    if (!Found) {
+      if (m_NotInIndexes.size() >= kMaxNotInIndexes)
+        m_NotInIndexes.clear();
+      m_NotInIndexes.insert(Key);
+    }
+    return false;
+  }
+
+  void AutoloadCallback::invalidateMissing() {
+    m_NotInIndexes.clear();
+    if (DynamicLibraryManager* DLM = m_Interpreter->getDynamicLibraryManager())
+      DLM->invalidateMissing();
+  }
 
+  void AutoloadCallback::TransactionUnloaded(const Transaction&) {
+    m_NotInIndexes.clear();
+  }
+
+  bool AutoloadCallback::loadIndex(llvm::StringRef Path) {
+    auto IdxOrErr = AutoloadIndex::open(Path);
+    if (!IdxOrErr) {
+      llvm::logAllUnhandledErrors(IdxOrErr.takeError(), cling::errs(),
+                                  "Error in cling::AutoloadCallback::loadIndex: ");
+      return false;
+    }
+    m_Indexes.push_back(std::move(*IdxOrErr));
+    invalidateMissing();
+    return true;
+  }
+
+  bool AutoloadCallback::lookupIndex(llvm::StringRef Name,
+                                     llvm::StringRef& Header,
+                                     llvm::StringRef& Library) const {
+    for (auto&& Idx : m_Indexes) {
+      if (auto E = Idx->lookup(Name)) {
+        Header = E->Header;
+        Library = E->Library;
+        return true;
+      }
+    }
+    return false;
   }
 
   bool AutoloadCallback::LookupObject (TagDecl *t) {
@@ -388,6 +476,8 @@ namespace cling {
     if (!HaveAutoLoadingMapMarker)
       return;
 
+    invalidateMissing();
+
     AutoLoadingVisitor defaultArgsStateCollector;
     Preprocessor& PP = m_Interpreter->getCI()->getPreprocessor();
     for (auto I = T.decls_begin(), E = T.decls_end(); I != E; ++I)
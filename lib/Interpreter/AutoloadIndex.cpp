@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------
+// CLING - the C++ LLVM-based InterpreterG :)
+//
+// This file is dual-licensed: you can choose to license it under the University
+// of Illinois Open Source License or the GNU Lesser General Public License. See
+// LICENSE.TXT for details.
+//------------------------------------------------------------------------------
+
+#include "AutoloadIndex.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstring>
+
+using namespace llvm;
+
+namespace {
+  static const char kMagic[8] = {'C', 'L', 'N', 'G', 'A', 'I', 'D', 'X'};
+  static const uint32_t kVersion = 1;
+  // magic, version, count, string table offset.
+  static const size_t kHeaderSize = sizeof(kMagic) + 3 * sizeof(uint32_t);
+  // name, header, library; each as offset and length.
+  static const size_t kEntrySize = 6 * sizeof(uint32_t);
+
+  static uint32_t read32(const char* P) {
+    return support::endian::read32le(P);
+  }
+}
+
+namespace cling {
+
+  AutoloadIndex::AutoloadIndex(std::unique_ptr<MemoryBuffer> Buffer)
+    : m_Buffer(std::move(Buffer)) {}
+
+  AutoloadIndex::~AutoloadIndex() {}
+
+  Expected<std::unique_ptr<AutoloadIndex>>
+  AutoloadIndex::open(StringRef Path) {
+    auto BufOrErr = MemoryBuffer::getFile(Path, /*IsText*/ false,
+                                          /*RequiresNullTerminator*/ false);
+    if (!BufOrErr)
+      return errorCodeToError(BufOrErr.getError());
+
+    auto malformed = [&Path]() {
+      return createStringError(inconvertibleErrorCode(),
+                               "'%s' is not a valid autoload index",
+                               Path.str().c_str());
+    };
+
+    std::unique_ptr<AutoloadIndex> Idx(new AutoloadIndex(std::move(*BufOrErr)));
+    StringRef Data = Idx->m_Buffer->getBuffer();
+    if (Data.size() < kHeaderSize ||
+        std::memcmp(Data.data(), kMagic, sizeof(kMagic)) != 0 ||
+        read32(Data.data() + sizeof(kMagic)) != kVersion)
+      return malformed();
+
+    uint32_t Count = read32(Data.data() + sizeof(kMagic) + 4);
+    uint32_t StringsOffset = read32(Data.data() + sizeof(kMagic) + 8);
+    if (StringsOffset > Data.size() || StringsOffset < kHeaderSize ||
+        (StringsOffset - kHeaderSize) / kEntrySize < Count)
+      return malformed();
+
+    Idx->m_NumEntries = Count;
+    Idx->m_Entries = Data.data() + kHeaderSize;
+    Idx->m_Strings = Data.drop_front(StringsOffset);
+    return std::move(Idx);
+  }
+
+  StringRef AutoloadIndex::getString(const char* Field) const {
+    uint32_t Offset = read32(Field), Len = read32(Field + 4);
+    if (Offset > m_Strings.size() || Len > m_Strings.size() - Offset)
+      return StringRef();
+    return m_Strings.substr(Offset, Len);
+  }
+
+  std::optional<AutoloadIndex::Entry>
+  AutoloadIndex::lookup(StringRef QualName) const {
+    uint32_t Lo = 0, Hi = m_NumEntries;
+    while (Lo < Hi) {
+      uint32_t Mid = Lo + (Hi - Lo) / 2;
+      const char* E = m_Entries + Mid * kEntrySize;
+      int Cmp = getString(E).compare(QualName);
+      if (Cmp == 0)
+        return Entry{getString(E + 8), getString(E + 16)};
+      if (Cmp < 0)
+        Lo = Mid + 1;
+      else
+        Hi = Mid;
+    }
+    return std::nullopt;
+  }
+
+  uint32_t AutoloadIndexWriter::intern(StringRef S) {
+    auto Ins = m_StringIDs.try_emplace(S, m_Strings.size());
+    if (Ins.second)
+      m_Strings.push_back(S.str());
+    return Ins.first->second;
+  }
+
+  void AutoloadIndexWriter::add(StringRef QualName, StringRef Header,
+                                StringRef Library) {
+    if (QualName.empty() || m_Names.count(QualName.str()))
+      return;
+    m_Names[QualName.str()] = Mapping{intern(Header), intern(Library)};
+  }
+
+  Error AutoloadIndexWriter::write(StringRef Path) const {
+    // Lay out the string table: names first, then the interned strings.
+    std::vector<uint32_t> StringOffsets;
+    StringOffsets.reserve(m_Strings.size());
+    uint32_t Offset = 0;
+    for (auto&& N : m_Names)
+      Offset += N.first.size();
+    for (auto&& S : m_Strings) {
+      StringOffsets.push_back(Offset);
+      Offset += S.size();
+    }
+
+    SmallString<256> TmpPath;
+    int FD;
+    if (std::error_code EC =
+        sys::fs::createUniqueFile(Path + ".tmp-%%%%%%%%", FD, TmpPath))
+      return errorCodeToError(EC);
+
+    {
+      raw_fd_ostream OS(FD, /*shouldClose*/ true);
+      support::endian::Writer W(OS, llvm::endianness::little);
+      OS.write(kMagic, sizeof(kMagic));
+      W.write<uint32_t>(kVersion);
+      W.write<uint32_t>(m_Names.size());
+      W.write<uint32_t>(kHeaderSize + m_Names.size() * kEntrySize);
+
+      uint32_t NameOffset = 0;
+      for (auto&& N : m_Names) {
+        W.write<uint32_t>(NameOffset);
+        W.write<uint32_t>(N.first.size());
+        W.write<uint32_t>(StringOffsets[N.second.Header]);
+        W.write<uint32_t>(m_Strings[N.second.Header].size());
+        W.write<uint32_t>(StringOffsets[N.second.Library]);
+        W.write<uint32_t>(m_Strings[N.second.Library].size());
+        NameOffset += N.first.size();
+      }
+      for (auto&& N : m_Names)
+        OS << N.first;
+      for (auto&& S : m_Strings)
+        OS << S;
+
+      OS.flush();
+      if (OS.has_error()) {
+        std::error_code EC = OS.error();
+        OS.clear_error();
+        sys::fs::remove(TmpPath);
+        return errorCodeToError(EC);
+      }
+    }
+
+    if (std::error_code EC = sys::fs::rename(TmpPath, Path)) {
+      sys::fs::remove(TmpPath);
+      return errorCodeToError(EC);
+    }
+    return Error::success();
+  }
+
+} // end namespace cling
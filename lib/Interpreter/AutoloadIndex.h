@@ -0,0 +1,97 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CLING - the C++ LLVM-based InterpreterG :)
+//
+// This file is dual-licensed: you can choose to license it under the University
+// of Illinois Open Source License or the GNU Lesser General Public License. See
+// LICENSE.TXT for details.
+//------------------------------------------------------------------------------
+
+#ifndef CLING_AUTOLOAD_INDEX_H
+#define CLING_AUTOLOAD_INDEX_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace llvm {
+  class MemoryBuffer;
+}
+
+namespace cling {
+
+  ///\brief Read-only view of a binary autoload index, mapping fully qualified
+  /// names to the header declaring them and, optionally, the library that
+  /// provides their definition.
+  ///
+  /// The file is memory-mapped and looked up in place by binary search, so
+  /// opening an index is O(1) and only the names actually looked up touch
+  /// their pages. Layout (all integers little-endian uint32_t):
+  ///   magic[8] version count stringTableOffset
+  ///   count x { name, nameLen, header, headerLen, library, libraryLen }
+  ///   string table
+  /// The entries are sorted by name; the offsets point into the string table.
+  ///
+  class AutoloadIndex {
+  public:
+    struct Entry {
+      llvm::StringRef Header;
+      llvm::StringRef Library;
+    };
+
+  private:
+    std::unique_ptr<llvm::MemoryBuffer> m_Buffer;
+    const char* m_Entries = nullptr;
+    llvm::StringRef m_Strings;
+    uint32_t m_NumEntries = 0;
+
+    AutoloadIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+    llvm::StringRef getString(const char* Field) const;
+
+  public:
+    ~AutoloadIndex();
+
+    ///\brief Maps the index stored in Path.
+    ///
+    static llvm::Expected<std::unique_ptr<AutoloadIndex>>
+    open(llvm::StringRef Path);
+
+    ///\brief Returns the entry for the fully qualified name QualName, if any.
+    ///
+    std::optional<Entry> lookup(llvm::StringRef QualName) const;
+
+    size_t size() const { return m_NumEntries; }
+  };
+
+  ///\brief Collects name to header/library mappings and serializes them in the
+  /// format read by AutoloadIndex. The first mapping added for a name wins.
+  ///
+  class AutoloadIndexWriter {
+    struct Mapping {
+      uint32_t Header, Library;
+    };
+    std::map<std::string, Mapping> m_Names;
+    llvm::StringMap<uint32_t> m_StringIDs;
+    std::vector<std::string> m_Strings;
+
+    uint32_t intern(llvm::StringRef S);
+
+  public:
+    void add(llvm::StringRef QualName, llvm::StringRef Header,
+             llvm::StringRef Library = llvm::StringRef());
+
+    size_t size() const { return m_Names.size(); }
+
+    ///\brief Writes the index to Path atomically.
+    ///
+    llvm::Error write(llvm::StringRef Path) const;
+  };
+} // end namespace cling
+
+#endif // CLING_AUTOLOAD_INDEX_H
@@ -11,21 +11,36 @@
 
 #include "IncrementalJIT.h"
 
+#include "cling/Utils/AST.h"
 #include "cling/Utils/Platform.h"
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Analysis/CGSCCPassManager.h"
 #include "llvm/Analysis/InlineCost.h"
+#include "llvm/Analysis/LoopAnalysisManager.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/Passes/StandardInstrumentations.h"
+#include "llvm/ProfileData/InstrProf.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/IPO/Inliner.h"
+#include "llvm/Transforms/Instrumentation/PGOInstrumentation.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Utils.h"
 
@@ -34,6 +49,7 @@
 #include "clang/Basic/CharInfo.h"
 #include "clang/Basic/CodeGenOptions.h"
 
+#include <algorithm>
 #include <optional>
 
 using namespace cling;
@@ -370,6 +386,242 @@ namespace {
   };
 }
 
+namespace {
+
+  // Lower the counter increments inserted by PGOInstrumentationGen to loads
+  // and stores of one exported array per function, which the interpreter
+  // reads back through the JIT. InstrProfilingLoweringPass would instead
+  // emit data for the compiler-rt profile runtime, which is not available to
+  // JITted code. Value profiling is dropped.
+  class LowerProfileCountersPass
+      : public PassInfoMixin<LowerProfileCountersPass> {
+    std::vector<BackendPasses::ProfiledFunction>& m_Profiled;
+
+  public:
+    LowerProfileCountersPass(std::vector<BackendPasses::ProfiledFunction>& P)
+        : m_Profiled(P) {}
+
+    PreservedAnalyses run(llvm::Module& M, ModuleAnalysisManager& AM) {
+      bool changed = false;
+      llvm::SmallPtrSet<GlobalVariable*, 16> NameVars;
+      for (auto &&F: M) {
+        GlobalVariable* Counters = nullptr;
+        for (Instruction& I : llvm::make_early_inc_range(instructions(F))) {
+          auto* II = dyn_cast<IntrinsicInst>(&I);
+          if (!II || !II->getCalledFunction()->getName().starts_with(
+                         "llvm.instrprof."))
+            continue;
+          auto* Inc = dyn_cast<InstrProfIncrementInst>(II);
+          if (Inc && F.hasName()) {
+            if (!Counters) {
+              uint32_t NumCounters = Inc->getNumCounters()->getZExtValue();
+              auto* Ty = ArrayType::get(Type::getInt64Ty(M.getContext()),
+                                        NumCounters);
+              // Weak, as for KeepLocalGVPass: inline functions can be
+              // instrumented in several modules; they then share counters.
+              Counters = new GlobalVariable(M, Ty, /*isConstant*/ false,
+                                            GlobalValue::WeakAnyLinkage,
+                                            Constant::getNullValue(Ty),
+                                            "__cling_profc_" + F.getName());
+              m_Profiled.push_back(
+                  {F.getName().str(),
+                   getPGOFuncNameVarInitializer(Inc->getName()).str(),
+                   Counters->getName().str(),
+                   Inc->getHash()->getZExtValue(), NumCounters});
+            }
+            IRBuilder<> B(Inc);
+            Value* Addr = B.CreateConstInBoundsGEP2_32(
+                Counters->getValueType(), Counters, 0,
+                Inc->getIndex()->getZExtValue());
+            Value* Count = B.CreateLoad(B.getInt64Ty(), Addr);
+            B.CreateStore(B.CreateAdd(Count, Inc->getStep()), Addr);
+          }
+          if (auto* Name = dyn_cast<GlobalVariable>(
+                  II->getArgOperand(0)->stripPointerCasts()))
+            NameVars.insert(Name);
+          II->eraseFromParent();
+          changed = true;
+        }
+      }
+      for (GlobalVariable* Name : NameVars)
+        if (Name->use_empty())
+          Name->eraseFromParent();
+      return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+    }
+  };
+
+  // Prepare the copy of an emitted module for the re-optimization of some of
+  // its functions: these stay the only definitions. All other functions
+  // become available_externally, to remain available for inlining; variables
+  // become declarations. Static initialization must not run again.
+  class PrepareReoptimizationPass
+      : public PassInfoMixin<PrepareReoptimizationPass> {
+    llvm::StringSet<> m_Functions;
+
+    // Aliases cannot refer to available_externally definitions; replace them
+    // by declarations of the (emitted) aliases.
+    static void replaceAlias(GlobalAlias& GA) {
+      llvm::Module& M = *GA.getParent();
+      GlobalValue* Decl;
+      if (auto* FTy = dyn_cast<FunctionType>(GA.getValueType()))
+        Decl = Function::Create(FTy, GlobalValue::ExternalLinkage,
+                                GA.getAddressSpace(), "", &M);
+      else
+        Decl = new GlobalVariable(M, GA.getValueType(), /*isConstant*/ false,
+                                  GlobalValue::ExternalLinkage,
+                                  /*Initializer*/ nullptr);
+      Decl->takeName(&GA);
+      GA.replaceAllUsesWith(Decl);
+      GA.eraseFromParent();
+    }
+
+  public:
+    PrepareReoptimizationPass(llvm::ArrayRef<std::string> Functions) {
+      for (const std::string& Name : Functions)
+        m_Functions.insert(Name);
+    }
+
+    PreservedAnalyses run(llvm::Module& M, ModuleAnalysisManager& AM) {
+      for (const char* Name : {"llvm.global_ctors", "llvm.global_dtors",
+                               "llvm.used", "llvm.compiler.used"})
+        if (GlobalVariable* GV = M.getNamedGlobal(Name))
+          GV->eraseFromParent();
+
+      for (GlobalAlias& GA : llvm::make_early_inc_range(M.aliases()))
+        if (!GA.hasLocalLinkage())
+          replaceAlias(GA);
+
+      for (auto &&F: M) {
+        if (F.isDeclaration() || F.hasLocalLinkage())
+          continue;
+        F.setComdat(nullptr);
+        if (m_Functions.count(F.getName())) {
+          F.setLinkage(GlobalValue::ExternalLinkage);
+          F.setVisibility(GlobalValue::DefaultVisibility);
+        } else {
+          F.setLinkage(GlobalValue::AvailableExternallyLinkage);
+        }
+      }
+      for (auto &&G: M.globals()) {
+        if (G.isDeclaration() || G.hasLocalLinkage())
+          continue;
+        G.setInitializer(nullptr); // make this a declaration
+        G.setComdat(nullptr);
+        G.setLinkage(GlobalValue::ExternalLinkage);
+      }
+      return PreservedAnalyses::none();
+    }
+  };
+
+  // Give the re-optimized functions new names, so that they can coexist with
+  // the code emitted before.
+  class RenameReoptimizedPass : public PassInfoMixin<RenameReoptimizedPass> {
+    llvm::ArrayRef<std::string> m_Functions;
+    llvm::StringRef m_Suffix;
+
+  public:
+    RenameReoptimizedPass(llvm::ArrayRef<std::string> Functions,
+                          llvm::StringRef Suffix)
+        : m_Functions(Functions), m_Suffix(Suffix) {}
+
+    PreservedAnalyses run(llvm::Module& M, ModuleAnalysisManager& AM) {
+      for (const std::string& Name : m_Functions)
+        if (Function* F = M.getFunction(Name))
+          F->setName(Name + m_Suffix);
+      return PreservedAnalyses::none();
+    }
+  };
+} // namespace
+
+///\brief Whether and how a run of the passes involves profiles.
+struct BackendPasses::ProfileConfig {
+  /// If set, instrument the module and collect its instrumented functions.
+  std::vector<ProfiledFunction>* Instrumented = nullptr;
+  /// If set, holds UseFile, the profile to re-optimize Functions with.
+  llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> UseFS;
+  std::string UseFile;
+  llvm::ArrayRef<std::string> Functions;
+  llvm::StringRef Suffix;
+};
+
+///\brief The passes for one kind of module, with the analysis managers and
+/// instrumentation they are registered with. The pipeline is built once and
+/// reused; the analysis results are cleared after every module.
+struct BackendPasses::Pipeline {
+  // What the pipeline was built for; CodeGenOptions change per transaction.
+  const LLVMContext* Context;
+  unsigned CGOptLevel;
+  unsigned CGOptimizeSize;
+
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+  PassInstrumentationCallbacks PIC;
+  StandardInstrumentations SI;
+  // The registered analyses refer to PB.
+  PassBuilder PB;
+  ModulePassManager MPM;
+
+  Pipeline(LLVMContext& Ctx, const CodeGenOptions& CGOpts, TargetMachine& TM)
+      : Context(&Ctx), CGOptLevel(CGOpts.OptimizationLevel),
+        CGOptimizeSize(CGOpts.OptimizeSize),
+        SI(Ctx, CGOpts.DebugPassManager),
+        PB(&TM, PipelineTuningOptions(), std::nullopt, &PIC) {}
+
+  bool isFor(const LLVMContext& Ctx, const CodeGenOptions& CGOpts) const {
+    return Context == &Ctx && CGOptLevel == CGOpts.OptimizationLevel &&
+           CGOptimizeSize == CGOpts.OptimizeSize;
+  }
+
+  void run(Module& M) {
+    MPM.run(M, MAM);
+    // The results refer to IR that is handed to the JIT.
+    MAM.clear();
+    CGAM.clear();
+    FAM.clear();
+    LAM.clear();
+  }
+};
+
+///\brief Whether F has a loop, i.e. an edge to a block that does not come
+/// later in reverse post order.
+static bool hasBackEdge(const Function& F) {
+  DenseMap<const BasicBlock*, unsigned> Order;
+  ReversePostOrderTraversal<const Function*> RPOT(&F);
+  unsigned N = 0;
+  for (const BasicBlock* BB : RPOT)
+    Order[BB] = N++;
+  for (const BasicBlock* BB : RPOT)
+    for (const BasicBlock* Succ : successors(BB))
+      if (Order.lookup(Succ) <= Order.lookup(BB))
+        return true;
+  return false;
+}
+
+///\brief Whether M is the wrapper of a prompt input, which runs once:
+/// optimizing it takes longer than it saves. Small modules defining anything
+/// else, e.g. a user function called in a loop, and wrappers that contain a
+/// loop are still optimized.
+static bool isTrivialModule(const Module& M) {
+  constexpr unsigned MaxInstructions = 32;
+  unsigned NumInstructions = 0;
+  for (const Function& F : M) {
+    if (F.isDeclaration())
+      continue;
+    // The wrapper and the initializers of the globals it declares.
+    const StringRef Name = F.getName();
+    if (!Name.contains(utils::Synthesize::UniquePrefix) &&
+        !Name.starts_with("__cxx_global_var_init") &&
+        !Name.starts_with("_GLOBAL__sub_I_"))
+      return false;
+    NumInstructions += F.getInstructionCount();
+    if (NumInstructions > MaxInstructions || hasBackEdge(F))
+      return false;
+  }
+  return true;
+}
+
 // From clang/lib/CodeGen/BackendUtil.cpp
 static OptimizationLevel mapToLevel(const CodeGenOptions& Opts) {
   switch (Opts.OptimizationLevel) {
@@ -406,18 +658,18 @@ BackendPasses::~BackendPasses() {
   //delete m_PMBuilder->Inliner;
 }
 
-void BackendPasses::CreatePasses(int OptLevel, llvm::ModulePassManager& MPM,
-                                 llvm::LoopAnalysisManager& LAM,
-                                 llvm::FunctionAnalysisManager& FAM,
-                                 llvm::CGSCCAnalysisManager& CGAM,
-                                 llvm::ModuleAnalysisManager& MAM,
-                                 PassInstrumentationCallbacks& PIC,
-                                 StandardInstrumentations& SI) {
+void BackendPasses::CreatePasses(int OptLevel, Pipeline& P,
+                                 const ProfileConfig& Profile, bool Optimize) {
+  ModulePassManager& MPM = P.MPM;
+  PassInstrumentationCallbacks& PIC = P.PIC;
+  PassBuilder& PB = P.PB;
 
   // TODO: Remove this pass once we upgrade past LLVM 19 that includes the fix.
   MPM.addPass(WorkAroundConstructorPriorityBugPass());
   MPM.addPass(KeepLocalGVPass());
   MPM.addPass(WeakTypeinfoVTablePass());
+  if (Profile.UseFS)
+    MPM.addPass(PrepareReoptimizationPass(Profile.Functions));
   MPM.addPass(ReuseExistingWeakSymbols(m_JIT));
   MPM.addPass(PreventLocalOptPass());
 
@@ -425,9 +677,19 @@ void BackendPasses::CreatePasses(int OptLevel, llvm::ModulePassManager& MPM,
   if (m_CGOpts.VerifyModule)
     MPM.addPass(VerifierPass());
 
+  // Instrumentation and profile use must see the same control flow graphs,
+  // so both happen before any optimization.
+  if (Profile.Instrumented) {
+    MPM.addPass(PGOInstrumentationGen());
+    MPM.addPass(LowerProfileCountersPass(*Profile.Instrumented));
+  } else if (Profile.UseFS) {
+    MPM.addPass(PGOInstrumentationUse(Profile.UseFile, /*RemappingFilename*/ "",
+                                      /*IsCS*/ false, Profile.UseFS));
+  }
+
   // Handle disabling of LLVM optimization, where we want to preserve the
   // internal module before any optimization.
-  if (m_CGOpts.DisableLLVMPasses) {
+  if (m_CGOpts.DisableLLVMPasses || !Optimize) {
     // Always keep at least ForceInline - NoInlining is deadly for libc++.
     // Inlining = CGOpts.NoInlining;
     MPM.addPass(AlwaysInlinerPass());
@@ -438,19 +700,20 @@ void BackendPasses::CreatePasses(int OptLevel, llvm::ModulePassManager& MPM,
 
     // Register a callback for disabling all other inliner passes.
     PIC.registerShouldRunOptionalPassCallback([](StringRef P, Any) {
-      if (P.equals("ModuleInlinerWrapperPass") ||
-          P.equals("InlineAdvisorAnalysisPrinterPass") ||
-          P.equals("PartialInlinerPass") || P.equals("buildInlinerPipeline") ||
-          P.equals("ModuleInlinerPass") || P.equals("InlinerPass") ||
-          P.equals("InlineAdvisorAnalysis") ||
-          P.equals("PartiallyInlineLibCallsPass") ||
-          P.equals("RelLookupTableConverterPass") ||
-          P.equals("InlineCostAnnotationPrinterPass") ||
-          P.equals("InlineSizeEstimatorAnalysisPrinterPass") ||
-          P.equals("InlineSizeEstimatorAnalysis"))
-        return false;
-
-      return true;
+      static const llvm::StringSet<> Disabled = {
+          "ModuleInlinerWrapperPass",
+          "InlineAdvisorAnalysisPrinterPass",
+          "PartialInlinerPass",
+          "buildInlinerPipeline",
+          "ModuleInlinerPass",
+          "InlinerPass",
+          "InlineAdvisorAnalysis",
+          "PartiallyInlineLibCallsPass",
+          "RelLookupTableConverterPass",
+          "InlineCostAnnotationPrinterPass",
+          "InlineSizeEstimatorAnalysisPrinterPass",
+          "InlineSizeEstimatorAnalysis"};
+      return !Disabled.count(P);
     });
   } else {
     // Register a callback for disabling RelLookupTableConverterPass.
@@ -459,11 +722,7 @@ void BackendPasses::CreatePasses(int OptLevel, llvm::ModulePassManager& MPM,
     });
   }
 
-  SI.registerCallbacks(PIC, &MAM);
-
-  PipelineTuningOptions PTO;
-  std::optional<PGOOptions> PGOOpt;
-  PassBuilder PB(&m_TM, PTO, PGOOpt, &PIC);
+  P.SI.registerCallbacks(PIC, &P.MAM);
 
   // Attempt to load pass plugins and register their callbacks with PB.
   for (auto& PluginFN : m_CGOpts.PassPlugins) {
@@ -473,11 +732,14 @@ void BackendPasses::CreatePasses(int OptLevel, llvm::ModulePassManager& MPM,
     }
   }
 
-  if (!m_CGOpts.DisableLLVMPasses) {
+  if (!m_CGOpts.DisableLLVMPasses && Optimize) {
     // Use the default pass pipeline. We also have to map our optimization
     // levels into one of the distinct levels used to configure the pipeline.
     OptimizationLevel Level = mapToLevel(m_CGOpts);
-    if (m_CGOpts.OptimizationLevel == 0) {
+    // Profiles are of no use to the O0 and O1 pipelines.
+    if (Profile.UseFS && Level.getSpeedupLevel() < 2)
+      Level = OptimizationLevel::O2;
+    if (Level == OptimizationLevel::O0) {
       // TODO: Remove this after https://reviews.llvm.org/D146200
       MPM.addPass(PB.buildO0DefaultPipeline(Level));
     } else {
@@ -491,38 +753,69 @@ void BackendPasses::CreatePasses(int OptLevel, llvm::ModulePassManager& MPM,
   if(!m_CGOpts.CudaGpuBinaryFileName.empty())
     MPM.addPass(UniqueCUDAStructorName());
 
+  if (Profile.UseFS)
+    MPM.addPass(RenameReoptimizedPass(Profile.Functions, Profile.Suffix));
+
   // Register all the basic analyses with the managers.
-  PB.registerModuleAnalyses(MAM);
-  PB.registerCGSCCAnalyses(CGAM);
-  PB.registerFunctionAnalyses(FAM);
-  PB.registerLoopAnalyses(LAM);
-  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+  PB.registerModuleAnalyses(P.MAM);
+  PB.registerCGSCCAnalyses(P.CGAM);
+  PB.registerFunctionAnalyses(P.FAM);
+  PB.registerLoopAnalyses(P.LAM);
+  PB.crossRegisterProxies(P.LAM, P.FAM, P.CGAM, P.MAM);
+}
+
+void BackendPasses::runOnModule(Module& M, int OptLevel,
+                                std::vector<ProfiledFunction>* Profiled) {
+  ProfileConfig Profile;
+  Profile.Instrumented = Profiled;
+  run(M, OptLevel, Profile);
+}
+
+void BackendPasses::runOnModuleWithProfile(Module& M, int OptLevel,
+                                           MemoryBufferRef ProfileData,
+                                           ArrayRef<std::string> Functions,
+                                           StringRef Suffix) {
+  auto FS = llvm::makeIntrusiveRefCnt<llvm::vfs::InMemoryFileSystem>();
+  ProfileConfig Profile;
+  Profile.UseFile = "/cling.profdata";
+  FS->addFile(Profile.UseFile, /*ModificationTime*/ 0,
+              MemoryBuffer::getMemBuffer(ProfileData,
+                                         /*RequiresNullTerminator*/ false));
+  Profile.UseFS = FS;
+  Profile.Functions = Functions;
+  Profile.Suffix = Suffix;
+  run(M, std::max(OptLevel, 2), Profile);
 }
 
-void BackendPasses::runOnModule(Module& M, int OptLevel) {
+void BackendPasses::run(Module& M, int OptLevel, const ProfileConfig& Profile) {
 
   if (OptLevel < 0)
     OptLevel = 0;
   if (OptLevel > 3)
     OptLevel = 3;
 
-  ModulePassManager MPM;
-  LoopAnalysisManager LAM;
-  FunctionAnalysisManager FAM;
-  CGSCCAnalysisManager CGAM;
-  ModuleAnalysisManager MAM;
-
-  PassInstrumentationCallbacks PIC;
-  StandardInstrumentations SI(M.getContext(), m_CGOpts.DebugPassManager);
-
-  CreatePasses(OptLevel, MPM, LAM, FAM, CGAM, MAM, PIC, SI);
-
   static constexpr std::array<llvm::CodeGenOptLevel, 4> CGOptLevel{
       {llvm::CodeGenOptLevel::None, llvm::CodeGenOptLevel::Less,
        llvm::CodeGenOptLevel::Default, llvm::CodeGenOptLevel::Aggressive}};
   // TM's OptLevel is used to build orc::SimpleCompiler passes for every Module.
   m_TM.setOptLevel(CGOptLevel[OptLevel]);
 
+  // The profile passes refer to the state of this run only.
+  if (Profile.Instrumented || Profile.UseFS) {
+    Pipeline P(M.getContext(), m_CGOpts, m_TM);
+    CreatePasses(OptLevel, P, Profile, /*Optimize*/ true);
+    P.run(M);
+    return;
+  }
+
+  const bool Optimize = !isTrivialModule(M);
+  std::unique_ptr<Pipeline>& P =
+      Optimize ? m_Pipelines[OptLevel] : m_TrivialPipeline;
+  if (!P || !P->isFor(M.getContext(), m_CGOpts)) {
+    P.reset(new Pipeline(M.getContext(), m_CGOpts, m_TM));
+    CreatePasses(OptLevel, *P, Profile, Optimize);
+  }
+
   // Now that we have all of the passes ready, run them.
-  MPM.run(M, MAM);
+  P->run(M);
 }
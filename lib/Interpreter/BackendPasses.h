@@ -10,17 +10,19 @@
 #ifndef CLING_BACKENDPASSES_H
 #define CLING_BACKENDPASSES_H
 
-#include "llvm/Analysis/CGSCCPassManager.h"
-#include "llvm/Analysis/LoopAnalysisManager.h"
-#include "llvm/IR/PassManager.h"
-#include "llvm/Passes/StandardInstrumentations.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
 
 #include <array>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace llvm {
   class Function;
   class LLVMContext;
+  class MemoryBufferRef;
   class Module;
   class TargetMachine;
 }
@@ -37,24 +39,79 @@ namespace cling {
   ///\brief Runs passes on IR. Remove once we can migrate from ModuleBuilder to
   /// what's in clang's CodeGen/BackendUtil.
   class BackendPasses {
+  public:
+    ///\brief A function instrumented by runOnModule() to count how often
+    /// the edges of its control flow graph are taken.
+    struct ProfiledFunction {
+      /// The IR name of the function.
+      std::string Name;
+      /// The name of the function's profile record.
+      std::string PGOName;
+      /// The symbol of the function's array of 64-bit counters in the JIT.
+      std::string CountersName;
+      /// The hash of the control flow graph the counters belong to.
+      uint64_t Hash;
+      uint32_t NumCounters;
+    };
+
+  private:
+    struct ProfileConfig;
+    struct Pipeline;
+
     llvm::TargetMachine& m_TM;
     IncrementalJIT &m_JIT;
     const clang::CodeGenOptions &m_CGOpts;
 
-    void CreatePasses(int OptLevel, llvm::ModulePassManager& MPM,
-                      llvm::LoopAnalysisManager& LAM,
-                      llvm::FunctionAnalysisManager& FAM,
-                      llvm::CGSCCAnalysisManager& CGAM,
-                      llvm::ModuleAnalysisManager& MAM,
-                      llvm::PassInstrumentationCallbacks& PIC,
-                      llvm::StandardInstrumentations& SI);
+    ///\brief The pipelines by optimization level, built on first use.
+    std::array<std::unique_ptr<Pipeline>, 4> m_Pipelines;
+
+    ///\brief The pipeline for modules too small to be worth optimizing.
+    std::unique_ptr<Pipeline> m_TrivialPipeline;
+
+    ///\brief Adds the passes to P and registers the analyses.
+    ///
+    ///\param[in] Optimize - Whether to run the optimization pipeline or only
+    ///   the passes that the JIT needs.
+    ///
+    void CreatePasses(int OptLevel, Pipeline& P, const ProfileConfig& Profile,
+                      bool Optimize);
+
+    void run(llvm::Module& M, int OptLevel, const ProfileConfig& Profile);
 
   public:
     BackendPasses(const clang::CodeGenOptions &CGOpts, IncrementalJIT &JIT,
                   llvm::TargetMachine& TM);
     ~BackendPasses();
 
-    void runOnModule(llvm::Module& M, int OptLevel);
+    ///\brief Runs the passes on a module before it is handed to the JIT.
+    ///
+    ///\param[in] M - The module to optimize.
+    ///\param[in] OptLevel - The optimization level of the transaction.
+    ///\param[out] Profiled - If not null, M is instrumented to count the
+    ///   executions of its functions and the instrumented functions are
+    ///   appended.
+    ///
+    void runOnModule(llvm::Module& M, int OptLevel,
+                     std::vector<ProfiledFunction>* Profiled = nullptr);
+
+    ///\brief Re-optimizes functions of a module that was instrumented by
+    /// runOnModule() and emitted before, using the counts collected since.
+    ///
+    /// M must be a copy of the module as it was before runOnModule(). Only
+    /// the given functions are kept, renamed by appending Suffix; all other
+    /// definitions refer to the code emitted before, but can still be inlined
+    /// into the re-optimized functions.
+    ///
+    ///\param[in] M - The copy of the module.
+    ///\param[in] OptLevel - The optimization level; at least 2 is used.
+    ///\param[in] ProfileData - An indexed profile (.profdata).
+    ///\param[in] Functions - The IR names of the functions to re-optimize.
+    ///\param[in] Suffix - Appended to the names of the re-optimized functions.
+    ///
+    void runOnModuleWithProfile(llvm::Module& M, int OptLevel,
+                                llvm::MemoryBufferRef ProfileData,
+                                llvm::ArrayRef<std::string> Functions,
+                                llvm::StringRef Suffix);
   };
 }
 
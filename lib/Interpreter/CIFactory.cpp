@@ -1237,13 +1237,87 @@ namespace {
     }
   }
 
+  ///\brief Checks that the inputs of a PCH still exist and are not newer
+  /// than the PCH. The PCH keeps their absolute paths, which break if the
+  /// installation is moved or the headers are edited or removed.
+  ///
+  class PCHInputsListener : public ASTReaderListener {
+    llvm::sys::TimePoint<> m_PCHTime;
+  public:
+    bool Usable = true;
+
+    PCHInputsListener(llvm::sys::TimePoint<> PCHTime) : m_PCHTime(PCHTime) {}
+
+    bool needsInputFileVisitation() override { return true; }
+    bool needsSystemInputFileVisitation() override { return true; }
+    bool visitInputFile(llvm::StringRef Filename, bool /*isSystem*/,
+                        bool /*isOverridden*/,
+                        bool /*isExplicitModule*/) override {
+      llvm::sys::fs::file_status Status;
+      if (llvm::sys::fs::status(Filename, Status) ||
+          Status.getLastModificationTime() > m_PCHTime)
+        Usable = false;
+      return Usable;
+    }
+  };
+
+  ///\brief Return the path of the runtime PCH built next to the runtime
+  /// headers, or an empty string if it is missing, if its inputs changed or
+  /// cannot be read, or if the invocation differs from the default one the
+  /// PCH was built with. The runtime header is then parsed instead.
+  ///
+  static std::string getRuntimePCH(llvm::StringRef ClingBin,
+                                   const CompilerOptions& COpts,
+                                   CompilerInstance& CI) {
+    if (ClingBin.empty() || COpts.Language || COpts.ResourceDir ||
+        COpts.SysRoot || COpts.NoBuiltinInc || COpts.NoCXXInc ||
+        COpts.StdVersion || COpts.StdLib || COpts.HasOutput ||
+        COpts.CxxModules || COpts.CUDAHost || COpts.CUDADevice)
+      return std::string();
+
+    if (cling::utils::ConvertEnvValueToBool(std::getenv("CLING_NO_RUNTIME_PCH")))
+      return std::string();
+
+    // Include paths and inputs do not change how the runtime headers parse;
+    // anything else might, so be conservative.
+    for (size_t I = 1, N = COpts.Remaining.size(); I < N; ++I) {
+      llvm::StringRef Arg(COpts.Remaining[I]);
+      if (Arg.starts_with("-") && Arg != "-v" && !Arg.starts_with("-I"))
+        return std::string();
+    }
+
+    llvm::SmallString<512> P(llvm::sys::path::parent_path(
+                               llvm::sys::path::parent_path(ClingBin)));
+    llvm::sys::path::append(P, "include", "cling", "Interpreter",
+                            "RuntimeUniverse.pch");
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(P.str(), Status) ||
+        !llvm::sys::fs::is_regular_file(Status))
+      return std::string();
+
+    PCHInputsListener Listener(Status.getLastModificationTime());
+    if (ASTReader::readASTFileControlBlock(P.str(), CI.getFileManager(),
+                                           CI.getModuleCache(),
+                                           CI.getPCHContainerReader(),
+                                           false /*FindModuleFileExt*/,
+                                           Listener,
+                                        /*ValidateDiagnosticOptions=*/false)
+        || !Listener.Usable) {
+      if (COpts.Verbose)
+        cling::log() << "Ignoring out of date runtime PCH \"" << P << "\"\n";
+      return std::string();
+    }
+    return std::string(P.str());
+  }
+
   static CompilerInstance*
   createCIImpl(std::unique_ptr<llvm::MemoryBuffer> Buffer,
                const CompilerOptions& COpts,
                const char* LLVMDir,
                std::unique_ptr<clang::ASTConsumer> customConsumer,
                const CIFactory::ModuleFileExtensions& moduleExtensions,
-               bool OnlyLex, bool HasInput = false) {
+               bool OnlyLex, bool HasInput = false,
+               bool RuntimePCH = false, bool* UsesRuntimePCH = nullptr) {
     // Follow clang -v convention of printing version on first line
     if (COpts.Verbose)
       cling::log() << "cling version " << ClingStringify(CLING_VERSION) << '\n';
@@ -1486,6 +1560,15 @@ namespace {
     CI->createFileManager(Overlay);
     clang::CompilerInvocation& Invocation = CI->getInvocation();
     std::string& PCHFile = Invocation.getPreprocessorOpts().ImplicitPCHInclude;
+    if (PCHFile.empty() && RuntimePCH && !debuggingEnabled) {
+      PCHFile = getRuntimePCH(ClingBin, COpts, *CI);
+      if (!PCHFile.empty()) {
+        if (COpts.Verbose)
+          cling::log() << "Using runtime PCH \"" << PCHFile << "\"\n";
+        if (UsesRuntimePCH)
+          *UsesRuntimePCH = true;
+      }
+    }
     bool InitLang = true, InitTarget = true;
     if (!PCHFile.empty()) {
       if (cling::utils::LookForFile(argvCompile, PCHFile,
@@ -1777,11 +1860,15 @@ CompilerInstance*
 CIFactory::createCI(llvm::StringRef Code, const InvocationOptions& Opts,
                     const char* LLVMDir,
                     std::unique_ptr<clang::ASTConsumer> consumer,
-                    const ModuleFileExtensions& moduleExtensions) {
+                    const ModuleFileExtensions& moduleExtensions,
+                    bool* UsesRuntimePCH /*= nullptr*/) {
+  if (UsesRuntimePCH)
+    *UsesRuntimePCH = false;
   return createCIImpl(llvm::MemoryBuffer::getMemBuffer(Code), Opts.CompilerOpts,
                       LLVMDir, std::move(consumer), moduleExtensions,
                       false /*OnlyLex*/,
-                      !Opts.IsInteractive());
+                      !Opts.IsInteractive(),
+                      Opts.RuntimePCH && !Opts.NoRuntime, UsesRuntimePCH);
 }
 
 CompilerInstance* CIFactory::createCI(
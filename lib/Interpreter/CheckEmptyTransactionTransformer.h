@@ -24,6 +24,9 @@ namespace cling {
     CheckEmptyTransactionTransformer(clang::Sema* S)
       : WrapperTransformer(S) { }
     Result Transform(clang::Decl* D) override;
+    const char* getName() const override {
+      return "CheckEmptyTransactionTransformer";
+    }
   };
 } // end namespace cling
 
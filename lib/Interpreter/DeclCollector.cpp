@@ -20,7 +20,10 @@
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/Token.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 
@@ -134,9 +137,31 @@ namespace cling {
  ASTTransformer::Result DeclCollector::TransformDecl(Decl* D) const {
     // We are sure it's safe to pipe it through the transformers
     // Consume late transformers init
-    for (size_t i = 0; D && i < m_TransactionTransformers.size(); ++i) {
-      ASTTransformer::Result NewDecl
-        = m_TransactionTransformers[i]->Transform(D, m_CurTransaction);
+    const CompilationOptions& CO = m_CurTransaction->getCompilationOpts();
+    llvm::SmallVector<ASTTransformer*, 4> Walkers;
+    for (size_t i = 0, e = m_TransactionTransformers.size(); D && i < e;) {
+      ASTTransformer* TT = m_TransactionTransformers[i++].get();
+      if (!TT->isEnabled(CO))
+        continue;
+      ASTTransformer::Result NewDecl(D, true);
+      if (!TT->usesSharedWalk())
+        NewDecl = TT->Transform(D, m_CurTransaction);
+      else {
+        // Walk D once for this and the following enabled transformers that
+        // only hook into the walk.
+        Walkers.assign(1, TT);
+        for (; i < e; ++i) {
+          ASTTransformer* Next = m_TransactionTransformers[i].get();
+          if (!Next->isEnabled(CO))
+            continue;
+          if (!Next->usesSharedWalk())
+            break;
+          Walkers.push_back(Next);
+        }
+        NewDecl = ASTTransformer::walk(D, m_CurTransaction, Walkers,
+                                       m_SharedWalkStats.Time);
+        ++m_SharedWalkStats.Decls;
+      }
       if (!NewDecl.getInt()) {
         m_CurTransaction->setIssuedDiags(Transaction::kErrors);
         return NewDecl;
@@ -146,6 +171,8 @@ namespace cling {
     if (FunctionDecl* FD = dyn_cast_or_null<FunctionDecl>(D)) {
       if (utils::Analyze::IsWrapper(FD)) {
         for (size_t i = 0; D && i < m_WrapperTransformers.size(); ++i) {
+          if (!m_WrapperTransformers[i]->isEnabled(CO))
+            continue;
           ASTTransformer::Result NewDecl
            = m_WrapperTransformers[i]->Transform(D, m_CurTransaction);
           if (!NewDecl.getInt()) {
@@ -159,6 +186,19 @@ namespace cling {
     return ASTTransformer::Result(D, true);
   }
 
+  void DeclCollector::printTransformerStats(llvm::raw_ostream& Out) const {
+    auto printRow = [&Out](const char* Name, const ASTTransformer::Stats& S) {
+      double MS = std::chrono::duration<double, std::milli>(S.Time).count();
+      Out << llvm::format("%-34s %10u %12.3f\n", Name, S.Decls, MS);
+    };
+    Out << llvm::format("%-34s %10s %12s\n", "transformer", "decls", "ms");
+    for (auto&& TT : m_TransactionTransformers)
+      printRow(TT->getName(), TT->getStats());
+    printRow("(shared walk)", m_SharedWalkStats);
+    for (auto&& WT : m_WrapperTransformers)
+      printRow(WT->getName(), WT->getStats());
+  }
+
   bool DeclCollector::Transform(DeclGroupRef& DGR) {
     // Do not tranform recursively, e.g. when emitting a DeclExtracted decl.
     if (m_Transforming)
@@ -17,6 +17,10 @@
 #include <vector>
 #include <memory>
 
+namespace llvm {
+  class raw_ostream;
+}
+
 namespace clang {
   class ASTContext;
   class CodeGenerator;
@@ -59,6 +63,11 @@ namespace cling {
     /// Whether Transform() is active; prevents recursion.
     bool m_Transforming = false;
 
+    ///\brief Number of declarations walked for transformers sharing a walk,
+    /// and the time spent walking them.
+    ///
+    mutable ASTTransformer::Stats m_SharedWalkStats;
+
     ///\brief Test whether the first decl of the DeclGroupRef comes from an AST
     /// file.
     ///
@@ -69,6 +78,10 @@ namespace cling {
 
     ///\brief Runs AST transformers on a transaction.
     ///
+    /// Transformers that are not enabled for the transaction's compilation
+    /// options are skipped; consecutive transformers using the shared walk
+    /// get D walked once for all of them.
+    ///
     ///\param[in] D - the decl to be transformed.
     ///
     ASTTransformer::Result TransformDecl(clang::Decl* D) const;
@@ -86,6 +99,11 @@ namespace cling {
         WT->SetConsumer(this);
     }
 
+    ///\brief Prints how many declarations each transformer handled and the
+    /// time it took.
+    ///
+    void printTransformerStats(llvm::raw_ostream& Out) const;
+
     void Setup(IncrementalParser* IncrParser,
                std::unique_ptr<ASTConsumer> Consumer,
                clang::Preprocessor& PP);
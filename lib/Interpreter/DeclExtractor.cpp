@@ -72,6 +72,10 @@ namespace cling {
   DeclExtractor::~DeclExtractor()
   { }
 
+  bool DeclExtractor::isEnabled(const CompilationOptions& CO) const {
+    return CO.DeclarationExtraction;
+  }
+
   WrapperTransformer::Result DeclExtractor::Transform(Decl* D) {
     if (!getCompilationOpts().DeclarationExtraction)
       return Result(D, true);
@@ -45,6 +45,8 @@ namespace cling {
     /// global scope.
     ///
     Result Transform(clang::Decl* D) override;
+    const char* getName() const override { return "DeclExtractor"; }
+    bool isEnabled(const CompilationOptions& CO) const override;
 
   private:
 
@@ -54,6 +54,17 @@ namespace cling {
       : m_Sema(S), m_CodeGen(CG), m_CurTransaction(T) { }
     ~DeclUnloader();
 
+    ///\brief The transaction whose declarations are being unloaded.
+    ///
+    const Transaction* getCurrentTransaction() const {
+      return m_CurTransaction;
+    }
+
+    ///\brief Switches to unloading the declarations of another transaction,
+    /// keeping the files to uncache collected so far.
+    ///
+    void setCurrentTransaction(const Transaction* T) { m_CurTransaction = T; }
+
     ///\brief Forwards to Visit(), excluding PCH declarations (known to cause
     /// problems).  If unsure, call this function instead of plain `Visit()'.
     ///\param[in] D - The declaration to unload
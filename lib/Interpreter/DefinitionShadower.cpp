@@ -96,6 +96,46 @@ namespace cling {
 
     if (InterpreterCallbacks *IC = m_Interp.getCallbacks())
       IC->DefinitionShadowed(D);
+
+    if (auto NS = dyn_cast<NamespaceDecl>(D->getDeclContext()))
+      if (isClingShadowNamespace(NS))
+        retireIfShadowed(NS);
+  }
+
+  bool DefinitionShadower::hasVisibleDecls(const DeclContext *DC) const {
+    StoredDeclsMap* Map = m_TU->getLookupPtr();
+    if (!Map)
+      return false;
+    for (Decl *I : DC->decls()) {
+      // E.g. the enumerators of an unscoped enum or an `extern "C"' block.
+      if (auto Nested = dyn_cast<DeclContext>(I))
+        if (Nested->isTransparentContext() && hasVisibleDecls(Nested))
+          return true;
+
+      auto ND = dyn_cast<NamedDecl>(I);
+      if (!ND || !ND->getDeclName() || ND->isInvalidDecl())
+        continue;
+      if (auto FD = dyn_cast<FunctionDecl>(ND))
+        if (utils::Analyze::IsWrapper(FD))
+          continue;
+
+      StoredDeclsMap::iterator Pos = Map->find(ND->getDeclName());
+      if (Pos == Map->end() || Pos->second.isNull())
+        continue;
+      for (NamedDecl *Visible : Pos->second.getLookupResult())
+        if (Visible == ND)
+          return true;
+    }
+    return false;
+  }
+
+  void DefinitionShadower::retireIfShadowed(NamespaceDecl *NS) const {
+    // The current transaction might still move declarations into its
+    // namespace, e.g. through DeclExtractor.
+    if (!NS->isInline() || NS == getTransaction()->getDefinitionShadowNS())
+      return;
+    if (!hasVisibleDecls(NS))
+      NS->setInline(false);
   }
 
   void DefinitionShadower::invalidatePreviousDefinitions(NamedDecl *D) const {
@@ -183,6 +223,10 @@ namespace cling {
       invalidatePreviousDefinitions(ND);
   }
 
+  bool DefinitionShadower::isEnabled(const CompilationOptions& CO) const {
+    return CO.EnableShadowing;
+  }
+
   ASTTransformer::Result DefinitionShadower::Transform(Decl* D) {
     Transaction *T = getTransaction();
     if (!T->getCompilationOpts().EnableShadowing)
@@ -15,6 +15,8 @@
 namespace clang {
   class ASTContext;
   class Decl;
+  class DeclContext;
+  class NamespaceDecl;
   class TranslationUnitDecl;
   class NamedDecl;
   class FunctionDecl;
@@ -48,6 +50,11 @@ namespace cling {
   /// It is still possible to reach previous definitions through the qualified
   /// name `__cling_N5xxx::yyy'.
   ///
+  /// Once nothing in a `__cling_N5xxx' namespace can be found from the TU
+  /// anymore, it is turned into a regular namespace: Clang would otherwise
+  /// search every inline namespace of the TU on lookups that do not find a
+  /// name directly, making such lookups slower with each redefinition.
+  ///
   class DefinitionShadower : public ASTTransformer {
   private:
     clang::ASTContext          &m_Context;
@@ -63,6 +70,17 @@ namespace cling {
     ///
     void hideDecl(clang::NamedDecl *D) const;
 
+    /// \brief Return whether a named declaration in `DC', or in a transparent
+    /// context nested in it, can be found from the TU scope.  Wrappers are
+    /// ignored.
+    ///
+    bool hasVisibleDecls(const clang::DeclContext *DC) const;
+
+    /// \brief Turn the `__cling_N5xxx' namespace `NS' into a regular
+    /// namespace if none of its declarations can be found from the TU scope.
+    ///
+    void retireIfShadowed(clang::NamespaceDecl *NS) const;
+
     /// \brief Lookup the given name and invalidate all clashing declarations
     /// (as seen from the TU).  `D' may be invalidated (if not a definition)
     /// and a definition for that declaration is in scope, e.g.
@@ -91,6 +109,8 @@ namespace cling {
     /// invalidate any previous definition currently in scope.
     ///
     Result Transform(clang::Decl* D) override;
+    const char* getName() const override { return "DefinitionShadower"; }
+    bool isEnabled(const CompilationOptions& CO) const override;
 
     /// \brief Return whether `DC` is a `__cling_N5xxx` inline namespace used
     /// for definition shadowing.
@@ -33,6 +33,7 @@ public:
     DeviceKernelInliner(clang::Sema* S);
 
     ASTTransformer::Result Transform(clang::Decl * D) override;
+    const char* getName() const override { return "DeviceKernelInliner"; }
 };
 
 }
@@ -0,0 +1,62 @@
+//------------------------------------------------------------------------------
+// CLING - the C++ LLVM-based InterpreterG :)
+//
+// This file is dual-licensed: you can choose to license it under the University
+// of Illinois Open Source License or the GNU Lesser General Public License. See
+// LICENSE.TXT for details.
+//------------------------------------------------------------------------------
+
+#include "DirectoryContentCache.h"
+
+#include "llvm/Support/Path.h"
+
+#include <chrono>
+
+using namespace llvm;
+
+namespace {
+  // Coarsest modification time resolution we expect (FAT has 2 seconds; ext3,
+  // HFS+ and many network file systems 1 second).
+  constexpr std::chrono::seconds MTimeGranularity(2);
+}
+
+namespace cling {
+
+  const DirectoryContentCache::Listing&
+  DirectoryContentCache::get(StringRef Dir) {
+    Listing& L = m_Dirs[Dir];
+    if (L.Generation == m_Generation)
+      return L;
+    L.Generation = m_Generation;
+
+    sys::fs::file_status Status;
+    if (sys::fs::status(Dir, Status) || !sys::fs::is_directory(Status)) {
+      L.Exists = false;
+      L.Names.clear();
+      return L;
+    }
+
+    // Adding or removing an entry updates the directory's mtime, unless it
+    // happens within the mtime's granularity after the listing was read.
+    if (L.Exists && !L.Racy && L.ModTime == Status.getLastModificationTime())
+      return L;
+
+    L.Exists = true;
+    L.ModTime = Status.getLastModificationTime();
+    L.Racy = std::chrono::system_clock::now() - L.ModTime < MTimeGranularity;
+    L.Names.clear();
+    std::error_code EC;
+    for (sys::fs::directory_iterator DirIt(Dir, EC), DirEnd;
+         DirIt != DirEnd && !EC; DirIt.increment(EC))
+      L.Names[sys::path::filename(DirIt->path())] = DirIt->type();
+    return L;
+  }
+
+  bool DirectoryContentCache::mayExist(StringRef Path) {
+    StringRef Dir = sys::path::parent_path(Path);
+    if (Dir.empty())
+      return true;
+    return get(Dir).Names.count(sys::path::filename(Path));
+  }
+
+} // end namespace cling
@@ -0,0 +1,79 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CLING - the C++ LLVM-based InterpreterG :)
+//
+// This file is dual-licensed: you can choose to license it under the University
+// of Illinois Open Source License or the GNU Lesser General Public License. See
+// LICENSE.TXT for details.
+//------------------------------------------------------------------------------
+
+#ifndef CLING_DIRECTORY_CONTENT_CACHE_H
+#define CLING_DIRECTORY_CONTENT_CACHE_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+
+namespace cling {
+
+  ///\brief Caches the listings of the library search directories, so that
+  /// probing a directory for a library does not cost a failed open/stat per
+  /// candidate name, which is a round trip on network file systems.
+  ///
+  /// A directory is read once and its names hashed; it is re-read only when
+  /// its modification time changed, or when it was read within a timestamp
+  /// granularity of that modification time, as an entry added in the same
+  /// tick would not change it. To bound the number of stat calls, the
+  /// modification time is checked at most once per lookup, as delimited by
+  /// the outermost LookupRAII.
+  ///
+  class DirectoryContentCache {
+  public:
+    typedef llvm::StringMap<llvm::sys::fs::file_type> Files;
+
+  private:
+    struct Listing {
+      llvm::sys::TimePoint<> ModTime;
+      unsigned Generation = 0;
+      bool Exists = false;
+      ///\brief The listing might miss entries added right after it was read.
+      bool Racy = false;
+      Files Names;
+    };
+
+    llvm::StringMap<Listing> m_Dirs;
+    unsigned m_Generation = 1;
+    unsigned m_LookupDepth = 0;
+
+    const Listing& get(llvm::StringRef Dir);
+
+  public:
+    ///\brief Delimits a lookup. Directories are revalidated on their first use
+    /// in the outermost lookup; nested lookups, e.g. of the dependencies of a
+    /// library being scanned, reuse that state.
+    ///
+    class LookupRAII {
+      DirectoryContentCache& m_Cache;
+    public:
+      LookupRAII(DirectoryContentCache& C) : m_Cache(C) {
+        if (!m_Cache.m_LookupDepth++)
+          ++m_Cache.m_Generation;
+      }
+      ~LookupRAII() { --m_Cache.m_LookupDepth; }
+    };
+
+    ///\brief Returns the names in Dir, with their types as reported by the
+    /// directory listing. Empty if Dir does not exist.
+    ///
+    const Files& getFiles(llvm::StringRef Dir) { return get(Dir).Names; }
+
+    ///\brief Returns false if Path certainly does not exist, i.e. if its
+    /// directory does not list it. Paths without a directory are not cached.
+    ///
+    bool mayExist(llvm::StringRef Path);
+
+    void clear() { m_Dirs.clear(); }
+  };
+} // end namespace cling
+
+#endif // CLING_DIRECTORY_CONTENT_CACHE_H
@@ -13,6 +13,8 @@
 #include "cling/Utils/Platform.h"
 #include "cling/Utils/Output.h"
 
+#include "DirectoryContentCache.h"
+
 #include "llvm/ADT/StringSet.h"
 #include "llvm/BinaryFormat/Magic.h"
 #include "llvm/Support/DynamicLibrary.h"
@@ -27,7 +29,8 @@
 constexpr unsigned DEBUG = 0;
 
 namespace cling {
-  DynamicLibraryManager::DynamicLibraryManager()  {
+  DynamicLibraryManager::DynamicLibraryManager()
+    : m_DirCache(new DirectoryContentCache()) {
     const llvm::SmallVector<const char*, 10> kSysLibraryEnv = {
       "LD_LIBRARY_PATH",
   #if __APPLE__
@@ -164,7 +167,7 @@ namespace cling {
       if (DEBUG > 7) {
         cling::errs() << "## Try: " << ThisPath;
       }
-      if (isSharedLibrary(ThisPath.str())) {
+      if (m_DirCache->mayExist(ThisPath) && isSharedLibrary(ThisPath.str())) {
         if (DEBUG > 7) {
           cling::errs() << " ... Found (in RPATH)!\n";
         }
@@ -179,7 +182,7 @@ namespace cling {
       if (DEBUG > 7) {
         cling::errs() << "## Try: " << ThisPath;
       }
-      if (isSharedLibrary(ThisPath.str())) {
+      if (m_DirCache->mayExist(ThisPath) && isSharedLibrary(ThisPath.str())) {
         if (DEBUG > 7) {
           cling::errs() << " ... Found (in SearchPaths)!\n";
         }
@@ -194,7 +197,7 @@ namespace cling {
       if (DEBUG > 7) {
         cling::errs() << "## Try: " << ThisPath;
       }
-      if (isSharedLibrary(ThisPath.str())) {
+      if (m_DirCache->mayExist(ThisPath) && isSharedLibrary(ThisPath.str())) {
         if (DEBUG > 7) {
           cling::errs() << " ... Found (in RUNPATH)!\n";
         }
@@ -296,6 +299,8 @@ namespace cling {
         RPathToStr2(RPath) << ", " << RPathToStr2(RunPath) << ", " << libLoader.str() << "\n";
     }
 
+    DirectoryContentCache::LookupRAII CacheLookup(*m_DirCache);
+
     // If it is an absolute path, don't try iterate over the paths.
     if (llvm::sys::path::is_absolute(libStem)) {
       if (isSharedLibrary(libStem))
@@ -310,7 +315,7 @@ namespace cling {
     if (libStem.starts_with_insensitive("@rpath")) {
       for (auto& P : RPath) {
         std::string result = substFront(libStem, "@rpath", P);
-        if (isSharedLibrary(result))
+        if (m_DirCache->mayExist(result) && isSharedLibrary(result))
           return normalizePath(result);
       }
     } else {
@@ -393,6 +398,7 @@ namespace cling {
     if (!insRes.second)
       return kLoadLibAlreadyLoaded;
     m_LoadedLibraries.insert(canonicalLoadedLib);
+    invalidateMissing();
     return kLoadLibSuccess;
   }
 
@@ -424,6 +430,7 @@ namespace cling {
 
     m_DyLibs.erase(dyLibHandle);
     m_LoadedLibraries.erase(canonicalLoadedLib);
+    invalidateMissing();
   }
 
   bool DynamicLibraryManager::isLibraryLoaded(llvm::StringRef fullPath) const {
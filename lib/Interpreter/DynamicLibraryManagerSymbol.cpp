@@ -13,6 +13,8 @@
 #include "cling/Utils/Platform.h"
 #include "cling/Utils/Output.h"
 
+#include "DirectoryContentCache.h"
+
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
@@ -659,6 +661,9 @@ namespace cling {
     }
 
     llvm::SmallSet<const BasePath*, 32> ScannedPaths;
+    DirectoryContentCache& DirCache =
+      m_DynamicLibraryManager.getDirectoryCache();
+    DirectoryContentCache::LookupRAII CacheLookup(DirCache);
 
     for (const DynamicLibraryManager::SearchPathInfo &Info : searchPaths) {
       if (Info.IsUser != searchSystemLibraries) {
@@ -847,20 +852,24 @@ namespace cling {
         if (DEBUG > 7) {
           cling::errs() << "Dyld::ScanForLibraries: Iterator: " << DirPath << "\n";
         }
-        std::error_code EC;
-        for (llvm::sys::fs::directory_iterator DirIt(DirPath, EC), DirEnd;
-             DirIt != DirEnd && !EC; DirIt.increment(EC)) {
+        // Copy the listing: HandleLib's dependency lookups might refresh it.
+        std::vector<std::pair<std::string, llvm::sys::fs::file_type>> Files;
+        for (const auto& F : DirCache.getFiles(DirPath))
+          Files.emplace_back(F.getKey().str(), F.getValue());
+        for (const auto& F : Files) {
+          llvm::SmallString<512> FilePath(DirPath);
+          llvm::sys::path::append(FilePath, F.first);
 
           if (DEBUG > 7) {
             cling::errs() << "Dyld::ScanForLibraries: Iterator >>> " <<
-              DirIt->path() << ", type=" << (short)(DirIt->type()) << "\n";
+              FilePath << ", type=" << (short)(F.second) << "\n";
           }
 
-          const llvm::sys::fs::file_type ft = DirIt->type();
+          const llvm::sys::fs::file_type ft = F.second;
           if (ft == llvm::sys::fs::file_type::regular_file) {
-              HandleLib(DirIt->path(), 0);
+              HandleLib(FilePath, 0);
           } else if (ft == llvm::sys::fs::file_type::symlink_file) {
-              std::string DepFileName_str = cached_realpath(DirIt->path());
+              std::string DepFileName_str = cached_realpath(FilePath);
               llvm::StringRef DepFileName = DepFileName_str;
               assert(!llvm::sys::fs::is_symlink_file(DepFileName));
               if (!llvm::sys::fs::is_directory(DepFileName))
@@ -1351,13 +1360,25 @@ namespace cling {
 
     m_Dyld = new Dyld(*this, shouldPermanentlyIgnore,
                       ObjF.getBinary()->getFileFormatName());
+    invalidateMissing();
   }
 
   std::string
   DynamicLibraryManager::searchLibrariesForSymbol(StringRef mangledName,
                                            bool searchSystem/* = true*/) const {
     assert(m_Dyld && "Must call initialize dyld before!");
-    return m_Dyld->searchLibrariesForSymbol(mangledName, searchSystem);
+    // A symbol missing from the system libraries is missing from the user
+    // libraries too.
+    if (m_MissingSymbols.count(mangledName))
+      return "";
+    std::string Lib = m_Dyld->searchLibrariesForSymbol(mangledName,
+                                                       searchSystem);
+    if (Lib.empty() && searchSystem) {
+      if (m_MissingSymbols.size() >= kMaxMissingSymbols)
+        m_MissingSymbols.clear();
+      m_MissingSymbols.insert(mangledName);
+    }
+    return Lib;
   }
 
   std::string DynamicLibraryManager::getSymbolLocation(void *func) {
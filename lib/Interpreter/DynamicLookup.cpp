@@ -243,6 +243,10 @@ namespace cling {
     m_NoELoc = m_NoRange.getEnd();
   }
 
+  bool EvaluateTSynthesizer::isEnabled(const CompilationOptions& CO) const {
+    return CO.DynamicScoping;
+  }
+
   ASTTransformer::Result EvaluateTSynthesizer::Transform(Decl* D) {
     if (!getCompilationOpts().DynamicScoping)
       return Result(D, true);
@@ -180,6 +180,8 @@ namespace cling {
     ~EvaluateTSynthesizer();
 
     Result Transform(clang::Decl* D) override;
+    const char* getName() const override { return "EvaluateTSynthesizer"; }
+    bool isEnabled(const CompilationOptions& CO) const override;
 
     MapTy& getSubstSymbolMap() { return m_SubstSymbolMap; }
 
@@ -18,6 +18,10 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/Sema.h"
 
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+
 using namespace clang;
 
 namespace {
@@ -69,6 +73,8 @@ namespace cling {
   ExternalInterpreterSource::ExternalInterpreterSource(
         const cling::Interpreter *parent, cling::Interpreter *child) :
         m_ParentInterpreter(parent), m_ChildInterpreter(child) {
+    Interpreter::QueryLockRAII ParentLock(*m_ParentInterpreter,
+                                          /*Exclusive=*/true);
 
     clang::DeclContext *parentTUDeclContext =
       m_ParentInterpreter->getCI()->getASTContext().getTranslationUnitDecl();
@@ -92,10 +98,7 @@ namespace cling {
 
   ExternalInterpreterSource::~ExternalInterpreterSource() {}
 
-  void ExternalInterpreterSource::ImportDecl(Decl *declToImport,
-                                   DeclarationName &childDeclName,
-                                   DeclarationName &parentDeclName,
-                                   const DeclContext *childCurrentDeclContext) {
+  NamedDecl* ExternalInterpreterSource::ImportDecl(Decl *declToImport) {
 
     // Don't do the import if we have a Function Template or using decls. They
     // are not supported by clang.
@@ -114,43 +117,24 @@ namespace cling {
               DS[0].getID() != clang::diag::err_unsupported_ast_node) &&
              "Import not supported!");
 #endif
-      return;
+      return nullptr;
     }
 
-    if (auto toOrErr = m_Importer->Import(declToImport)) {
-      if (NamedDecl *importedNamedDecl = llvm::dyn_cast<NamedDecl>(*toOrErr)) {
-        SetExternalVisibleDeclsForName(childCurrentDeclContext,
-                                       importedNamedDecl->getDeclName(),
-                                       importedNamedDecl);
-      }
-      // Put the name of the Decl imported with the
-      // DeclarationName coming from the parent, in  my map.
-      m_ImportedDecls[childDeclName] = parentDeclName;
-    } else {
-      logAllUnhandledErrors(toOrErr.takeError(), llvm::errs(),
-                            "Error importing decl");
-    }
+    if (auto toOrErr = m_Importer->Import(declToImport))
+      return llvm::dyn_cast<NamedDecl>(*toOrErr);
+
+    logAllUnhandledErrors(toOrErr.takeError(), llvm::errs(),
+                          "Error importing decl");
+    return nullptr;
   }
 
   void ExternalInterpreterSource::ImportDeclContext(
-                                  DeclContext *declContextToImport,
-                                  DeclarationName &childDeclName,
-                                  DeclarationName &parentDeclName,
-                                  const DeclContext *childCurrentDeclContext) {
+                                  DeclContext *declContextToImport) {
 
     if (auto toOrErr = m_Importer->ImportContext(declContextToImport)) {
 
       DeclContext *importedDC = *toOrErr;
       importedDC->setHasExternalVisibleStorage(true);
-      if (NamedDecl *importedND = llvm::dyn_cast<NamedDecl>(importedDC)) {
-        SetExternalVisibleDeclsForName(childCurrentDeclContext,
-                                       importedND->getDeclName(),
-                                       importedND);
-      }
-
-      // Put the name of the DeclContext imported with the
-      // DeclarationName coming from the parent, in  my map.
-      m_ImportedDecls[childDeclName] = parentDeclName;
 
       // And also put the declaration context I found from the parent Interpreter
       // in the map of the child Interpreter to have it for the future.
@@ -163,26 +147,69 @@ namespace cling {
 
   bool ExternalInterpreterSource::Import(DeclContext::lookup_result lookup_result,
                                 const DeclContext *childCurrentDeclContext,
-                                DeclarationName &childDeclName,
-                                DeclarationName &parentDeclName) {
-
+                                DeclarationName childDeclName) {
 
-
-    for (DeclContext::lookup_iterator I = lookup_result.begin(),
-          E = lookup_result.end(); I != E; ++I) {
+    // Collect the whole overload set before publishing it: setting the
+    // visible decls once per imported decl would leave only the last one.
+    llvm::SmallVector<NamedDecl*, 4> importedDecls;
+    for (NamedDecl* parentDecl : lookup_result) {
       // Check if this Name we are looking for is
       // a DeclContext (for example a Namespace, function etc.).
-      if (DeclContext *declContextToImport = llvm::dyn_cast<DeclContext>(*I)) {
-
-        ImportDeclContext(declContextToImport, childDeclName,
-                          parentDeclName, childCurrentDeclContext);
+      if (DeclContext *declContextToImport = llvm::dyn_cast<DeclContext>(parentDecl))
+        ImportDeclContext(declContextToImport);
 
-      }
-      ImportDecl(*I, childDeclName, parentDeclName, childCurrentDeclContext);
+      if (NamedDecl* importedDecl = ImportDecl(parentDecl))
+        if (!llvm::is_contained(importedDecls, importedDecl))
+          importedDecls.push_back(importedDecl);
     }
+
+    if (importedDecls.empty())
+      return false;
+
+    SetExternalVisibleDeclsForName(childCurrentDeclContext, childDeclName,
+                                   importedDecls);
     return true;
   }
 
+  DeclarationName
+  ExternalInterpreterSource::getParentName(DeclarationName childName) {
+    ASTContext& parentCtx = m_ParentInterpreter->getCI()->getASTContext();
+    switch (childName.getNameKind()) {
+    case DeclarationName::Identifier:
+      return &parentCtx.Idents.get(childName.getAsIdentifierInfo()->getName());
+    case DeclarationName::CXXOperatorName:
+      return parentCtx.DeclarationNames.getCXXOperatorName(
+                                        childName.getCXXOverloadedOperator());
+    case DeclarationName::CXXLiteralOperatorName:
+      return parentCtx.DeclarationNames.getCXXLiteralOperatorName(
+          &parentCtx.Idents.get(childName.getCXXLiteralIdentifier()->getName()));
+    case DeclarationName::CXXConstructorName:
+    case DeclarationName::CXXDestructorName: {
+      // The name is keyed on the class type; map it through the class we
+      // imported it from.
+      const CXXRecordDecl* childRD =
+        childName.getCXXNameType()->getAsCXXRecordDecl();
+      if (!childRD)
+        return DeclarationName();
+      auto I = m_ImportedDeclContexts.find(childRD);
+      if (I == m_ImportedDeclContexts.end())
+        return DeclarationName();
+      const auto* parentRD = llvm::dyn_cast<CXXRecordDecl>(I->second);
+      if (!parentRD)
+        return DeclarationName();
+      CanQualType T =
+        parentCtx.getCanonicalType(parentCtx.getRecordType(parentRD));
+      if (childName.getNameKind() == DeclarationName::CXXConstructorName)
+        return parentCtx.DeclarationNames.getCXXConstructorName(T);
+      return parentCtx.DeclarationNames.getCXXDestructorName(T);
+    }
+    default:
+      // Conversion functions and deduction guides are only found through
+      // names we imported before.
+      return DeclarationName();
+    }
+  }
+
   ///\brief This is the one of the most important function of the class
   /// since from here initiates the lookup and import part of the missing
   /// Decl(s) (Contexts).
@@ -195,23 +222,21 @@ namespace cling {
     assert(childCurrentDeclContext->hasExternalVisibleStorage() &&
            "DeclContext has no visible decls in storage");
 
-    //Check if we have already found this declaration Name before
-    DeclarationName parentDeclName;
-    std::map<clang::DeclarationName,
-             clang::DeclarationName>::iterator IDecl =
-                                            m_ImportedDecls.find(childDeclName);
-    if (IDecl != m_ImportedDecls.end()) {
-      parentDeclName = IDecl->second;
-    } else {
-      // Get the identifier info from the parent interpreter
-      // for this Name.
-      std::string name = childDeclName.getAsString();
-      IdentifierTable &parentIdentifierTable =
-                            m_ParentInterpreter->getCI()->getASTContext().Idents;
-      IdentifierInfo &parentIdentifierInfo =
-                            parentIdentifierTable.get(name);
-      parentDeclName = DeclarationName(&parentIdentifierInfo);
+    // Importing reads the parent's AST and adds to its identifier table;
+    // children on other threads (see InterpreterPool) must not overlap.
+    Interpreter::QueryLockRAII ParentLock(*m_ParentInterpreter,
+                                          /*Exclusive=*/true);
+
+    // Misses stay valid until the parent committed or unloaded a transaction.
+    // Transactions are recycled, so their address cannot tell.
+    const unsigned long long parentState
+      = m_ParentInterpreter->getStateGeneration();
+    if (parentState != m_ParentStateOfMisses) {
+      m_Misses.clear();
+      m_ParentStateOfMisses = parentState;
     }
+    if (m_Misses.count({childCurrentDeclContext, childDeclName}))
+      return false;
 
     // Search in the map of the stored Decl Contexts for this
     // Decl Context.
@@ -221,18 +246,32 @@ namespace cling {
     // then do the lookup using the stored pointer.
     if (IDeclContext == m_ImportedDeclContexts.end()) return false;
 
-    DeclContext *parentDeclContext = IDeclContext->second;
+    //Check if we have already found this declaration Name before
+    DeclarationName parentDeclName;
+    std::map<clang::DeclarationName,
+             clang::DeclarationName>::iterator IDecl =
+                                            m_ImportedDecls.find(childDeclName);
+    if (IDecl != m_ImportedDecls.end())
+      parentDeclName = IDecl->second;
+    else
+      parentDeclName = getParentName(childDeclName);
 
-    DeclContext::lookup_result lookup_result =
+    if (parentDeclName) {
+      DeclContext *parentDeclContext = IDeclContext->second;
+      DeclContext::lookup_result lookup_result =
                                     parentDeclContext->lookup(parentDeclName);
 
-    // Check if we found this Name in the parent interpreter
-    if (!lookup_result.empty()) {
-      if (Import(lookup_result,
-                 childCurrentDeclContext, childDeclName, parentDeclName))
+      // Check if we found this Name in the parent interpreter
+      if (!lookup_result.empty() &&
+          Import(lookup_result, childCurrentDeclContext, childDeclName)) {
+        // Put the name of the Decl imported with the
+        // DeclarationName coming from the parent, in  my map.
+        m_ImportedDecls[childDeclName] = parentDeclName;
         return true;
+      }
     }
 
+    m_Misses.insert({childCurrentDeclContext, childDeclName});
     return false;
   }
 
@@ -253,27 +292,30 @@ namespace cling {
     // then do the lookup using the stored pointer.
     if (IDeclContext == m_ImportedDeclContexts.end()) return ;
 
+    Interpreter::QueryLockRAII ParentLock(*m_ParentInterpreter,
+                                          /*Exclusive=*/true);
     DeclContext *parentDeclContext = IDeclContext->second;
 
     // Filter the decls from the external source using the stem information
     // stored in Sema.
     StringRef filter =
       m_ChildInterpreter->getCI()->getPreprocessor().getCodeCompletionFilter();
-    for (DeclContext::decl_iterator IDeclContext =
-                                      parentDeclContext->decls_begin(),
-                                    EDeclContext =
-                                      parentDeclContext->decls_end();
-                              IDeclContext != EDeclContext; ++IDeclContext) {
-      if (NamedDecl* parentDecl = llvm::dyn_cast<NamedDecl>(*IDeclContext)) {
-        DeclarationName childDeclName = parentDecl->getDeclName();
-        if (auto II = childDeclName.getAsIdentifierInfo()) {
+    // Group the imported decls by name, so that overloads are published
+    // together.
+    llvm::MapVector<DeclarationName, llvm::SmallVector<NamedDecl*, 4>> byName;
+    for (Decl* D : parentDeclContext->decls()) {
+      if (NamedDecl* parentDecl = llvm::dyn_cast<NamedDecl>(D)) {
+        if (auto II = parentDecl->getDeclName().getAsIdentifierInfo()) {
           StringRef name = II->getName();
           if (!name.empty() && name.starts_with(filter))
-            ImportDecl(parentDecl, childDeclName, childDeclName,
-                       childDeclContext);
+            if (NamedDecl* importedDecl = ImportDecl(parentDecl))
+              byName[importedDecl->getDeclName()].push_back(importedDecl);
         }
       }
     }
+    for (auto& Named : byName)
+      SetExternalVisibleDeclsForName(childDeclContext, Named.first,
+                                     Named.second);
 
     const_cast<DeclContext *>(childDeclContext)->
                                       setHasExternalVisibleStorage(false);
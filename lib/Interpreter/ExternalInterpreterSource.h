@@ -10,8 +10,11 @@
 #ifndef CLING_EXTERNAL_INTERPRETER_SOURCE
 #define CLING_EXTERNAL_INTERPRETER_SOURCE
 
+#include "clang/AST/DeclarationName.h"
 #include "clang/AST/ExternalASTSource.h"
 
+#include "llvm/ADT/DenseSet.h"
+
 #include <string>
 #include <map>
 
@@ -53,10 +56,27 @@ namespace cling {
         ///
         std::map <clang::DeclarationName, clang::DeclarationName > m_ImportedDecls;
 
+        ///\brief Names the parent does not declare in the parent counterpart
+        /// of the DeclContext. clang asks again for every lookup of a name
+        /// it did not get, so remember the misses until the parent changes.
+        ///
+        llvm::DenseSet<std::pair<const clang::DeclContext*,
+                                 clang::DeclarationName>> m_Misses;
+
+        ///\brief The parent's state generation when m_Misses was filled, see
+        /// Interpreter::getStateGeneration().
+        ///
+        unsigned long long m_ParentStateOfMisses = 0;
+
         ///\brief The ASTImporter which does the actual imports from the parent
         /// interpreter to the child interpreter.
         std::unique_ptr<clang::ASTImporter> m_Importer;
 
+        ///\brief Translates a name of the child into the parent's ASTContext.
+        /// Returns an empty name if it has no counterpart (yet).
+        ///
+        clang::DeclarationName getParentName(clang::DeclarationName childName);
+
       public:
         ExternalInterpreterSource(const cling::Interpreter *parent,
                                   cling::Interpreter *child);
@@ -68,20 +88,16 @@ namespace cling {
                               const clang::DeclContext *childCurrentDeclContext,
                               clang::DeclarationName childDeclName) override;
 
+        ///\brief Imports all the decls of lookupResult and makes them visible
+        /// at once as childDeclName in childCurrentDeclContext.
+        ///
         bool Import(clang::DeclContext::lookup_result lookupResult,
                     const clang::DeclContext *childCurrentDeclContext,
-                    clang::DeclarationName &childDeclName,
-                    clang::DeclarationName &parentDeclName);
-
-        void ImportDeclContext(clang::DeclContext *declContextToImport,
-                               clang::DeclarationName &childDeclName,
-                               clang::DeclarationName &parentDeclName,
-                               const clang::DeclContext *childCurrentDeclContext);
-
-        void ImportDecl(clang::Decl *declToImport,
-                        clang::DeclarationName &childDeclName,
-                        clang::DeclarationName &parentDeclName,
-                        const clang::DeclContext *childCurrentDeclContext);
+                    clang::DeclarationName childDeclName);
+
+        void ImportDeclContext(clang::DeclContext *declContextToImport);
+
+        clang::NamedDecl* ImportDecl(clang::Decl *declToImport);
 
         void addToImportedDecls(clang::DeclarationName child,
                                 clang::DeclarationName parent) {
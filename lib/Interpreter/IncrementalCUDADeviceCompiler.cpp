@@ -16,8 +16,11 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/VirtualFileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/MC/TargetRegistry.h>
@@ -27,12 +30,102 @@
 
 #include <algorithm>
 #include <bitset>
+#include <chrono>
 #include <optional>
 #include <string>
 #include <system_error>
 
 namespace cling {
 
+  ///\brief Serves the fatbinary of the latest input to the host CodeGen under
+  /// CodeGenOptions::CudaGpuBinaryFileName, without a round trip through the
+  /// disk. All other paths fall through to the file systems below it in the
+  /// host's OverlayFileSystem.
+  class CUDAFatbinFileSystem : public llvm::vfs::FileSystem {
+    typedef std::shared_ptr<const std::string> Contents_t;
+
+    class File : public llvm::vfs::File {
+      llvm::vfs::Status m_Status;
+      Contents_t m_Contents;
+
+    public:
+      File(llvm::vfs::Status Status, Contents_t Contents)
+          : m_Status(std::move(Status)), m_Contents(std::move(Contents)) {}
+
+      llvm::ErrorOr<llvm::vfs::Status> status() override { return m_Status; }
+
+      llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+      getBuffer(const llvm::Twine& Name, int64_t /*FileSize*/,
+                bool /*RequiresNullTerminator*/,
+                bool /*IsVolatile*/) override {
+        return llvm::MemoryBuffer::getMemBufferCopy(*m_Contents, Name);
+      }
+
+      std::error_code close() override { return std::error_code(); }
+    };
+
+    const std::string m_Path;
+    const llvm::sys::fs::UniqueID m_UID;
+    llvm::sys::TimePoint<> m_MTime;
+    Contents_t m_Contents;
+
+    bool isFatbin(const llvm::Twine& Path) const {
+      return m_Contents && Path.str() == m_Path;
+    }
+
+    llvm::vfs::Status makeStatus() const {
+      return llvm::vfs::Status(m_Path, m_UID, m_MTime, /*User*/ 0,
+                               /*Group*/ 0, m_Contents->size(),
+                               llvm::sys::fs::file_type::regular_file,
+                               llvm::sys::fs::perms::all_read);
+    }
+
+  public:
+    CUDAFatbinFileSystem(llvm::StringRef Path)
+        : m_Path(Path.str()), m_UID(llvm::vfs::getNextVirtualUniqueID()) {}
+
+    llvm::StringRef getContents() const {
+      return m_Contents ? llvm::StringRef(*m_Contents) : llvm::StringRef();
+    }
+
+    void setContents(std::string Contents) {
+      m_Contents = std::make_shared<const std::string>(std::move(Contents));
+      m_MTime = std::chrono::time_point_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now());
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status>
+    status(const llvm::Twine& Path) override {
+      if (!isFatbin(Path))
+        return std::make_error_code(std::errc::no_such_file_or_directory);
+      return makeStatus();
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>>
+    openFileForRead(const llvm::Twine& Path) override {
+      if (!isFatbin(Path))
+        return std::make_error_code(std::errc::no_such_file_or_directory);
+      // The file keeps the contents it was opened with.
+      return std::unique_ptr<llvm::vfs::File>(
+          new File(makeStatus(), m_Contents));
+    }
+
+    llvm::vfs::directory_iterator dir_begin(const llvm::Twine& /*Dir*/,
+                                            std::error_code& EC) override {
+      EC = std::make_error_code(std::errc::no_such_file_or_directory);
+      return llvm::vfs::directory_iterator();
+    }
+
+    llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+      return std::string();
+    }
+
+    std::error_code
+    setCurrentWorkingDirectory(const llvm::Twine& /*Path*/) override {
+      return std::error_code();
+    }
+  };
+
   IncrementalCUDADeviceCompiler::IncrementalCUDADeviceCompiler(
       const std::string& filePath, const int optLevel,
       const cling::InvocationOptions& invocationOptions,
@@ -44,6 +137,12 @@ namespace cling {
       return;
     }
 
+    // The host CodeGen reads the fatbinary through its virtual file system;
+    // CIFactory always sets up an OverlayFileSystem.
+    m_FatbinFS = new CUDAFatbinFileSystem(m_FatbinFilePath);
+    static_cast<llvm::vfs::OverlayFileSystem&>(CI.getVirtualFileSystem())
+        .pushOverlay(m_FatbinFS);
+
     setCuArgs(CI.getLangOpts(), invocationOptions,
               CI.getCodeGenOpts().getDebugInfo(),
               llvm::Triple(CI.getTargetOpts().Triple));
@@ -102,6 +201,12 @@ namespace cling {
     m_Init = true;
   }
 
+  IncrementalCUDADeviceCompiler::~IncrementalCUDADeviceCompiler() {}
+
+  llvm::StringRef IncrementalCUDADeviceCompiler::getFatbinary() const {
+    return m_FatbinFS ? m_FatbinFS->getContents() : llvm::StringRef();
+  }
+
   void IncrementalCUDADeviceCompiler::setCuArgs(
       const clang::LangOptions& langOpts,
       const cling::InvocationOptions& invocationOptions,
@@ -226,10 +331,7 @@ namespace cling {
     if (CR == Interpreter::CompilationResult::kMoreInputExpected)
       return true;
 
-    if (!generatePTX() || !generateFatbinary())
-      return false;
-
-    return true;
+    return updateFatbinary();
   }
 
   // FIXME: see process()
@@ -252,10 +354,7 @@ namespace cling {
     if (CR == Interpreter::CompilationResult::kMoreInputExpected)
       return true;
 
-    if (!generatePTX() || !generateFatbinary())
-      return false;
-
-    return true;
+    return updateFatbinary();
   }
 
   // FIXME: see process()
@@ -277,32 +376,57 @@ namespace cling {
     return true;
   }
 
-  bool cling::IncrementalCUDADeviceCompiler::generatePTX() {
+  ///\brief Whether the device compilation emitted anything: host code is
+  /// not emitted by the PTX interpreter, so a module without definitions
+  /// stems from an input without __global__ / __device__ entities.
+  static bool hasDeviceCode(const llvm::Module& module) {
+    for (const llvm::Function& F : module)
+      if (!F.isDeclaration())
+        return true;
+    for (const llvm::GlobalVariable& GV : module.globals())
+      if (!GV.isDeclaration())
+        return true;
+    return false;
+  }
+
+  bool IncrementalCUDADeviceCompiler::updateFatbinary() {
+    const Transaction* T = m_PTX_interp->getLastTransaction();
+    llvm::Module* module = T ? T->getModule() : nullptr;
+    // The host CodeGen needs some fatbinary, even if there is no device code
+    // yet; afterwards keep the current one unless there is new device code.
+    if (!getFatbinary().empty() && (!module || !hasDeviceCode(*module)))
+      return true;
+    if (module && !generatePTX(*module))
+      return false;
+    return generateFatbinary();
+  }
+
+  bool IncrementalCUDADeviceCompiler::generatePTX(llvm::Module& module) {
     // delete compiled PTX code of last input
     m_PTX_code = "";
 
-    llvm::Module* module = m_PTX_interp->getLastTransaction()->getModule();
-
-    std::string error;
-    auto Target =
-        llvm::TargetRegistry::lookupTarget(module->getTargetTriple(), error);
+    if (!m_TargetMachine) {
+      std::string error;
+      auto Target =
+          llvm::TargetRegistry::lookupTarget(module.getTargetTriple(), error);
 
-    if (!Target) {
-      llvm::errs() << error;
-      return 1;
-    }
+      if (!Target) {
+        llvm::errs() << error;
+        return false;
+      }
 
-    // is not important, because PTX does not use any object format
-    std::optional<llvm::Reloc::Model> RM =
-        std::optional<llvm::Reloc::Model>(llvm::Reloc::Model::PIC_);
+      // is not important, because PTX does not use any object format
+      std::optional<llvm::Reloc::Model> RM =
+          std::optional<llvm::Reloc::Model>(llvm::Reloc::Model::PIC_);
 
-    llvm::TargetOptions TO = llvm::TargetOptions();
+      llvm::TargetOptions TO = llvm::TargetOptions();
 
-    llvm::TargetMachine* targetMachine = Target->createTargetMachine(
-        module->getTargetTriple(),
-        std::string("sm_").append(std::to_string(m_CuArgs->smVersion)), "", TO,
-        RM);
-    module->setDataLayout(targetMachine->createDataLayout());
+      m_TargetMachine.reset(Target->createTargetMachine(
+          module.getTargetTriple(),
+          std::string("sm_").append(std::to_string(m_CuArgs->smVersion)), "",
+          TO, RM));
+    }
+    module.setDataLayout(m_TargetMachine->createDataLayout());
 
     llvm::raw_svector_ostream dest(m_PTX_code);
 
@@ -311,26 +435,19 @@ namespace cling {
     // object file is not supported and do not make sense
     llvm::CodeGenFileType FileType = llvm::CodeGenFileType::AssemblyFile;
 
-    if (targetMachine->addPassesToEmitFile(pass, dest, /*DwoOut*/ nullptr,
-                                           FileType)) {
+    if (m_TargetMachine->addPassesToEmitFile(pass, dest, /*DwoOut*/ nullptr,
+                                             FileType)) {
       llvm::errs() << "TargetMachine can't emit assembler code";
-      return 1;
+      return false;
     }
 
-    return pass.run(*module);
+    pass.run(module);
+    return true;
   }
 
   bool IncrementalCUDADeviceCompiler::generateFatbinary() {
-    // FIXME: At the moment the fatbin code must be writen to a file so that
-    // CodeGen can use it. This should be replaced by a in-memory solution
-    // (e.g. virtual file).
-    std::error_code EC;
-    llvm::raw_fd_ostream os(m_FatbinFilePath, EC, llvm::sys::fs::OF_None);
-    if (EC) {
-      llvm::errs() << "ERROR: cannot generate file " << m_FatbinFilePath
-                   << "\n";
-      return false;
-    }
+    std::string fatbin;
+    llvm::raw_string_ostream os(fatbin);
 
     // implementation is adapted from clangJIT
     // (https://github.com/hfinkel/llvm-project-cxxjit/blob/cxxjit/clang/lib/CodeGen/JIT.cpp)
@@ -405,13 +522,15 @@ namespace cling {
     os.write((char*)&fatBinFileHeader, fatBinFileHeader.HeaderSize);
     os << m_PTX_code;
 
+    m_FatbinFS->setContents(std::move(os.str()));
     return true;
   }
 
   void IncrementalCUDADeviceCompiler::dump() {
     llvm::outs() << "CUDA device compiler is valid: " << m_Init << "\n"
                  << "file path: " << m_FilePath << "\n"
-                 << "fatbin file path: " << m_FatbinFilePath << "\n"
+                 << "fatbin file path: " << m_FatbinFilePath << " (in memory, "
+                 << getFatbinary().size() << " bytes)\n"
                  << "m_CuArgs c++ standard: " << m_CuArgs->cppStdVersion << "\n"
                  << "m_CuArgs host triple: " << m_CuArgs->hostTriple.str()
                  << "\n"
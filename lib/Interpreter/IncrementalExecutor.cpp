@@ -26,7 +26,14 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Module.h"
 #include "llvm/ADT/SmallPtrSet.h"
-
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ProfileData/InstrProfWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include <algorithm>
 #include <iostream>
 
 using namespace llvm;
@@ -91,6 +98,9 @@ void IncrementalExecutor::AddAtExitFunc(void (*func)(void*), void* arg,
   // Register a CXAAtExit function
   cling::internal::SpinLockGuard slg(m_AtExitFuncsSpinLock);
   m_AtExitFuncs[T].emplace_back(func, arg);
+  if (T)
+    const_cast<Transaction*>(T)->getMemoryUsage().AtExit
+      += sizeof(CXAAtExitElement);
 }
 
 void unresolvedSymbol()
@@ -151,6 +161,118 @@ static bool isPracticallyEmptyModule(const llvm::Module* M) {
   return M->empty() && M->global_empty() && M->alias_empty();
 }
 
+void IncrementalExecutor::emitModule(Transaction& T) {
+  if (m_BackendPasses) {
+    const int OptLevel = T.getCompilationOpts().OptLevel;
+    if (m_ProfileInstrumentation) {
+      ProfiledModule PM;
+      PM.Module = llvm::CloneModule(*T.getModule());
+      m_BackendPasses->runOnModule(*T.getModule(), OptLevel, &PM.Functions);
+      if (!PM.Functions.empty())
+        m_ProfiledModules[&T] = std::move(PM);
+    } else {
+      m_BackendPasses->runOnModule(*T.getModule(), OptLevel);
+    }
+  }
+
+  m_JIT->addModule(T);
+}
+
+std::unique_ptr<llvm::MemoryBuffer>
+IncrementalExecutor::createProfileData() const {
+  llvm::InstrProfWriter Writer;
+  if (llvm::Error Err =
+          Writer.mergeProfileKind(llvm::InstrProfKind::IRInstrumentation))
+    llvm::consumeError(std::move(Err)); // cannot conflict, nothing added yet
+  // Functions instrumented in several modules share their counters.
+  llvm::StringSet<> Seen;
+  for (auto&& I : m_ProfiledModules) {
+    for (const BackendPasses::ProfiledFunction& F : I.second.Functions) {
+      if (!Seen.insert(F.CountersName).second)
+        continue;
+      const uint64_t* Counters = static_cast<const uint64_t*>(
+          m_JIT->getSymbolAddress(F.CountersName, /*IncludeHostSymbols*/false));
+      if (!Counters)
+        continue;
+      llvm::NamedInstrProfRecord Record(
+          F.PGOName, F.Hash,
+          std::vector<uint64_t>(Counters, Counters + F.NumCounters));
+      Writer.addRecord(std::move(Record), [](llvm::Error Err) {
+        llvm::logAllUnhandledErrors(std::move(Err), cling::errs(),
+                                    "[createProfileData] ");
+      });
+    }
+  }
+  return Writer.writeBuffer();
+}
+
+///\brief Whether the user selected the function with the given IR name.
+static bool isSelectedFunction(llvm::StringRef IRName,
+                               llvm::StringRef Selection) {
+  if (Selection.empty() || IRName == Selection)
+    return true;
+  std::string Demangled = platform::Demangle(IRName.str());
+  llvm::StringRef D = Demangled;
+  return D == Selection ||
+         (D.starts_with(Selection) && D.substr(Selection.size())
+                                          .starts_with("("));
+}
+
+unsigned IncrementalExecutor::reoptimizeWithProfile(llvm::StringRef Function,
+                                                    const Transaction* OnlyT) {
+  if (!m_BackendPasses || m_ProfiledModules.empty())
+    return 0;
+
+  std::unique_ptr<llvm::MemoryBuffer> ProfileData = createProfileData();
+  unsigned NumReoptimized = 0;
+  for (auto&& I : m_ProfiledModules) {
+    const Transaction* T = I.first;
+    if (OnlyT && T != OnlyT)
+      continue;
+
+    std::vector<std::string> Selected;
+    for (const BackendPasses::ProfiledFunction& F : I.second.Functions) {
+      if (!isSelectedFunction(F.Name, Function))
+        continue;
+      // Without counts, the profile would only mark the function as cold.
+      const uint64_t* Counters = static_cast<const uint64_t*>(
+          m_JIT->getSymbolAddress(F.CountersName, /*IncludeHostSymbols*/false));
+      if (Counters &&
+          std::any_of(Counters, Counters + F.NumCounters,
+                      [](uint64_t Count) { return Count != 0; }))
+        Selected.push_back(F.Name);
+    }
+    if (Selected.empty())
+      continue;
+
+    std::unique_ptr<llvm::Module> M = llvm::CloneModule(*I.second.Module);
+    std::string Suffix = ".pgo" + std::to_string(++m_NumReoptimizedModules);
+    m_BackendPasses->runOnModuleWithProfile(
+        *M, T->getCompilationOpts().OptLevel,
+        ProfileData->getMemBufferRef(), Selected, Suffix);
+    if (llvm::Error Err = m_JIT->addReoptimizedModule(*T, std::move(M),
+                                                      Selected, Suffix)) {
+      llvm::logAllUnhandledErrors(std::move(Err), cling::errs(),
+                                  "[reoptimizeWithProfile] ");
+      continue;
+    }
+    NumReoptimized += Selected.size();
+  }
+  return NumReoptimized;
+}
+
+bool IncrementalExecutor::writeProfile(llvm::StringRef FileName) const {
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(FileName, EC, llvm::sys::fs::OF_None);
+  if (EC) {
+    cling::errs() << "Cannot write profile '" << FileName
+                  << "': " << EC.message() << "\n";
+    return false;
+  }
+  OS << createProfileData()->getBuffer();
+  return true;
+}
+
 
 IncrementalExecutor::ExecutionResult
 IncrementalExecutor::runStaticInitializersOnce(Transaction& T) {
@@ -293,8 +415,15 @@ bool IncrementalExecutor::diagnoseUnresolvedSymbols(llvm::StringRef trigger,
   if (m_unresolvedSymbols.size() == 1 && *m_unresolvedSymbols.begin() == trigger)
     return false;
 
+  if (m_UnprovidedGeneration != m_DyLibManager.getGeneration()) {
+    m_UnprovidedSymbols.clear();
+    m_UnprovidedGeneration = m_DyLibManager.getGeneration();
+  }
+
   // Issue callback to TCling!!
   for (const std::string& sym : m_unresolvedSymbols) {
+    if (m_UnprovidedSymbols.count(sym))
+      continue;
     // We emit callback to LibraryLoadingFailed when we get error with error message.
     if (InterpreterCallbacks* C = m_Callbacks)
       if (C->LibraryLoadingFailed(sym, "", false, false))
@@ -334,12 +463,19 @@ bool IncrementalExecutor::diagnoseUnresolvedSymbols(llvm::StringRef trigger,
           << "Maybe you need to load the corresponding shared library?\n";
     }
 
+    if (m_UnprovidedSymbols.count(sym))
+      continue;
     std::string libName = m_DyLibManager.searchLibrariesForSymbol(sym,
                                                         /*searchSystem=*/ true);
     if (!libName.empty())
       cling::errs() << "Symbol found in '" << libName << "';"
                     << " did you mean to load it with '.L "
                     << libName << "'?\n";
+    else {
+      if (m_UnprovidedSymbols.size() >= kMaxUnprovidedSymbols)
+        m_UnprovidedSymbols.clear();
+      m_UnprovidedSymbols.insert(sym);
+    }
 
     //llvm::Function *ff = m_engine->FindFunctionNamed(i->c_str());
     // i could also reference a global variable, in which case ff == 0.
@@ -22,6 +22,7 @@
 #include "cling/Utils/Casting.h"
 #include "cling/Utils/OrderedMap.h"
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringRef.h"
@@ -40,6 +41,7 @@ namespace clang {
 
 namespace llvm {
   class GlobalValue;
+  class MemoryBuffer;
   class Module;
   class TargetMachine;
   namespace orc {
@@ -122,6 +124,15 @@ namespace cling {
     ///
     mutable std::unordered_set<std::string> m_unresolvedSymbols;
 
+    ///\brief Unresolved symbols that neither the LibraryLoadingFailed
+    /// callbacks nor the library search could provide, so that both are
+    /// skipped when the symbol is missed again. Valid for one generation of
+    /// m_DyLibManager and bounded by kMaxUnprovidedSymbols.
+    ///
+    mutable std::unordered_set<std::string> m_UnprovidedSymbols;
+    mutable unsigned m_UnprovidedGeneration = 0;
+    enum { kMaxUnprovidedSymbols = 1024 };
+
 #if 0 // See FIXME in IncrementalExecutor.cpp
     ///\brief The diagnostics engine, printing out issues coming from the
     /// incremental executor.
@@ -132,6 +143,28 @@ namespace cling {
     ///
     DynamicLibraryManager m_DyLibManager;
 
+    ///\brief A module compiled with profile instrumentation: its copy from
+    /// before the optimizations, to be re-optimized with the collected counts,
+    /// and its instrumented functions.
+    ///
+    struct ProfiledModule {
+      std::unique_ptr<llvm::Module> Module;
+      std::vector<BackendPasses::ProfiledFunction> Functions;
+    };
+
+    ///\brief The instrumented modules by their transactions.
+    ///
+    std::map<const Transaction*, ProfiledModule> m_ProfiledModules;
+
+    ///\brief Whether the modules emitted next are instrumented.
+    ///
+    bool m_ProfileInstrumentation = false;
+
+    ///\brief The number of modules re-optimized so far, to name the
+    /// re-optimized functions uniquely.
+    ///
+    unsigned m_NumReoptimizedModules = 0;
+
   public:
     enum ExecutionResult {
       kExeSuccess,
@@ -169,10 +202,50 @@ namespace cling {
     void addGenerator(std::unique_ptr<llvm::orc::DefinitionGenerator> G);
 
     ///\brief Unload a set of JIT symbols.
-    llvm::Error unloadModule(const Transaction& T) const {
+    llvm::Error unloadModule(const Transaction& T) {
+      m_ProfiledModules.erase(&T);
       return m_JIT->removeModule(T);
     }
 
+    ///\brief Unload the JIT symbols of several transactions at once.
+    llvm::Error unloadModules(llvm::ArrayRef<const Transaction*> Ts) {
+      for (const Transaction* T : Ts)
+        m_ProfiledModules.erase(T);
+      return m_JIT->removeModules(Ts);
+    }
+
+    ///\brief Instrument the modules emitted from now on to count how often
+    /// their branches are taken, see reoptimizeWithProfile().
+    void enableProfileInstrumentation(bool value) {
+      m_ProfileInstrumentation = value;
+    }
+    bool isProfileInstrumentationEnabled() const {
+      return m_ProfileInstrumentation;
+    }
+
+    ///\brief Re-optimizes instrumented functions that were executed, using
+    /// the counts collected so far, and resolves their symbols to the
+    /// re-optimized code from then on. Code that was linked against the
+    /// instrumented functions before keeps calling them.
+    ///
+    ///\param[in] Function - The function to re-optimize, by its IR name or
+    ///   its demangled name with or without the parameter list; all executed
+    ///   functions if empty.
+    ///\param[in] T - If set, only functions emitted by this transaction.
+    ///
+    ///\returns the number of re-optimized functions.
+    ///
+    unsigned reoptimizeWithProfile(llvm::StringRef Function,
+                                   const Transaction* T = nullptr);
+
+    ///\brief Writes the counts collected so far as an indexed profile
+    /// (.profdata), e.g. for `clang -fprofile-use` when compiling the same
+    /// code ahead of time.
+    ///
+    ///\returns false if the file could not be written.
+    ///
+    bool writeProfile(llvm::StringRef FileName) const;
+
     ///\brief Run the static initializers of all modules collected to far.
     ExecutionResult runStaticInitializersOnce(Transaction& T);
 
@@ -235,13 +308,11 @@ namespace cling {
     ///
     /// @param[in] module - The module to pass to the execution engine.
     /// @param[in] optLevel - The optimization level to be used.
-    void emitModule(Transaction &T) const {
-      if (m_BackendPasses)
-        m_BackendPasses->runOnModule(*T.getModule(),
-                                     T.getCompilationOpts().OptLevel);
+    void emitModule(Transaction &T);
 
-      m_JIT->addModule(T);
-    }
+    ///\brief Creates an indexed profile from the counters of all
+    /// instrumented functions.
+    std::unique_ptr<llvm::MemoryBuffer> createProfileData() const;
 
     ///\brief Report and empty m_unresolvedSymbols.
     ///\return true if m_unresolvedSymbols was non-empty.
@@ -20,6 +20,7 @@
 #include <clang/Frontend/CompilerInstance.h>
 
 #include <llvm/ExecutionEngine/JITLink/EHFrameSupport.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
 #include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
 #include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
 #include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
@@ -31,6 +32,7 @@
 #include <llvm/TargetParser/Host.h>
 #include <llvm/TargetParser/Triple.h>
 
+#include <mutex>
 #include <optional>
 
 #ifdef __linux__
@@ -215,6 +217,48 @@ namespace {
     }
   };
 
+  /// Reports the size of the code and data sections of each JITLink graph once
+  /// its memory is allocated.
+  class MemoryAccountingPlugin : public ObjectLinkingLayer::Plugin {
+  public:
+    using RecordFn = unique_function<void(MaterializationResponsibility&,
+                                          size_t, size_t)>;
+
+    MemoryAccountingPlugin(RecordFn Record) : m_Record(std::move(Record)) {}
+
+    void modifyPassConfig(MaterializationResponsibility& MR, LinkGraph& G,
+                          PassConfiguration& Config) override {
+      Config.PostAllocationPasses.push_back([this, &MR](LinkGraph& G) {
+        size_t Code = 0, Data = 0;
+        for (Section& Sec : G.sections()) {
+          size_t Size = 0;
+          for (Block* B : Sec.blocks())
+            Size += B->getSize();
+          if ((Sec.getMemProt() & MemProt::Exec) != MemProt::None)
+            Code += Size;
+          else
+            Data += Size;
+        }
+        m_Record(MR, Code, Data);
+        return Error::success();
+      });
+    }
+
+    Error notifyFailed(MaterializationResponsibility& MR) override {
+      return Error::success();
+    }
+
+    Error notifyRemovingResources(JITDylib& JD, ResourceKey K) override {
+      return Error::success();
+    }
+
+    void notifyTransferringResources(JITDylib& JD, ResourceKey DstKey,
+                                     ResourceKey SrcKey) override {}
+
+  private:
+    RecordFn m_Record;
+  };
+
   /// A DynamicLibrarySearchGenerator that uses ResourceTracker to remember
   /// which symbols were resolved through dlsym during a transaction's reign.
   /// Enables JITDyLib forgetting symbols upon unloading of a shared library.
@@ -363,8 +407,8 @@ static bool UseJITLink(const Triple& TT) {
   return jitLink;
 }
 
-static std::unique_ptr<TargetMachine>
-CreateTargetMachine(const clang::CompilerInstance& CI, bool JITLink) {
+static JITTargetMachineBuilder
+CreateTargetMachineBuilder(const clang::CompilerInstance& CI, bool JITLink) {
   CodeGenOptLevel OptLevel = CodeGenOptLevel::Default;
   switch (CI.getCodeGenOpts().OptimizationLevel) {
     case 0: OptLevel = CodeGenOptLevel::None; break;
@@ -405,9 +449,36 @@ CreateTargetMachine(const clang::CompilerInstance& CI, bool JITLink) {
     // by upstream.
   }
 
-  return cantFail(JTMB.createTargetMachine());
+  return JTMB;
 }
 
+static std::unique_ptr<TargetMachine>
+CreateTargetMachine(const clang::CompilerInstance& CI, bool JITLink) {
+  return cantFail(CreateTargetMachineBuilder(CI, JITLink).createTargetMachine());
+}
+
+/// Compiles with the TargetMachine of the JIT, which is not thread-safe. While
+/// another thread uses it, e.g. when child interpreters materialize code of
+/// their parent concurrently, compile with a TargetMachine of its own instead,
+/// like ConcurrentIRCompiler does.
+class SharedTargetMachineCompiler : public IRCompileLayer::IRCompiler {
+  SimpleCompiler Shared;
+  ConcurrentIRCompiler Concurrent;
+  std::mutex SharedMutex;
+
+public:
+  SharedTargetMachineCompiler(TargetMachine& TM, JITTargetMachineBuilder JTMB)
+      : IRCompiler(irManglingOptionsFromTargetOptions(TM.Options)),
+        Shared(TM), Concurrent(std::move(JTMB)) {}
+
+  Expected<std::unique_ptr<MemoryBuffer>> operator()(Module& M) override {
+    std::unique_lock<std::mutex> Lock(SharedMutex, std::try_to_lock);
+    if (Lock.owns_lock())
+      return Shared(M);
+    return Concurrent(M);
+  }
+};
+
 #if defined(__linux__) && defined(__GLIBC__)
 static SymbolMap GetListOfLibcNonsharedSymbols(const LLJIT& Jit) {
   // Inject a number of symbols that may be in libc_nonshared.a where they are
@@ -438,6 +509,9 @@ namespace cling {
 ///\brief Creates JIT event listener to allow profiling of JITted code with perf
 llvm::JITEventListener* createPerfJITEventListener();
 
+///\brief Creates the JITLink counterpart of createPerfJITEventListener()
+std::unique_ptr<llvm::orc::ObjectLinkingLayer::Plugin> createPerfJITLinkPlugin();
+
 IncrementalJIT::~IncrementalJIT() {
   // FIXME: This should ideally happen in the right order without explicitly
   // doing this. We started seeing failing tests (eg, tutorial-hist-cumulative,
@@ -484,6 +558,14 @@ IncrementalJIT::IncrementalJIT(
           ES, std::make_unique<ClingJITLinkMemoryManager>(PageSize));
       ObjLinkingLayer->addPlugin(std::make_unique<EHFrameRegistrationPlugin>(
           ES, std::make_unique<InProcessEHFrameRegistrar>()));
+      ObjLinkingLayer->addPlugin(std::make_unique<MemoryAccountingPlugin>(
+          [this](MaterializationResponsibility& MR, size_t Code, size_t Data) {
+            recordEmittedMemory(MR, Code, Data);
+          }));
+#ifdef __linux__
+      if (cling::utils::ConvertEnvValueToBool(std::getenv("CLING_PROFILE")))
+        ObjLinkingLayer->addPlugin(cling::createPerfJITLinkPlugin());
+#endif
       return ObjLinkingLayer;
     }
 
@@ -493,6 +575,18 @@ IncrementalJIT::IncrementalJIT(
     };
     auto Layer =
         std::make_unique<RTDyldObjectLinkingLayer>(ES, std::move(GetMemMgr));
+    Layer->setNotifyLoaded([this](MaterializationResponsibility& MR,
+                                  const object::ObjectFile& Obj,
+                                  const RuntimeDyld::LoadedObjectInfo&) {
+      size_t Code = 0, Data = 0;
+      for (const object::SectionRef& Sec : Obj.sections()) {
+        if (Sec.isText())
+          Code += Sec.getSize();
+        else if (Sec.isData() || Sec.isBSS())
+          Data += Sec.getSize();
+      }
+      recordEmittedMemory(MR, Code, Data);
+    });
 
     // Register JIT event listeners if enabled
     if (cling::utils::ConvertEnvValueToBool(std::getenv("CLING_DEBUG")))
@@ -520,7 +614,8 @@ IncrementalJIT::IncrementalJIT(
 
   Builder.setCompileFunctionCreator([&](llvm::orc::JITTargetMachineBuilder)
   -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
-    return std::make_unique<SimpleCompiler>(*m_TM);
+    return std::make_unique<SharedTargetMachineCompiler>(
+        *m_TM, CreateTargetMachineBuilder(CI, m_JITLink));
   });
 
   char LinkerPrefix = this->m_TM->createDataLayout().getGlobalPrefix();
@@ -611,9 +706,27 @@ std::unique_ptr<llvm::orc::DefinitionGenerator> IncrementalJIT::getGenerator() {
       [&](StringRef Name) { return Jit->lookupLinkerMangled(Name); });
 }
 
+void IncrementalJIT::recordEmittedMemory(MaterializationResponsibility& MR,
+                                         size_t Code, size_t Data) {
+  // The tracker is defunct if the transaction got unloaded meanwhile.
+  consumeError(MR.withResourceKeyDo([&](ResourceKey K) {
+    std::lock_guard<std::mutex> Lock(m_TransactionsByKeyMutex);
+    auto I = m_TransactionsByKey.find(K);
+    if (I == m_TransactionsByKey.end())
+      return;
+    Transaction::MemoryUsage& Usage = I->second->getMemoryUsage();
+    Usage.JITCode += Code;
+    Usage.JITData += Data;
+  }));
+}
+
 void IncrementalJIT::addModule(Transaction& T) {
   ResourceTrackerSP MainRT = Jit->getMainJITDylib().createResourceTracker();
   m_MainResourceTrackers[&T] = MainRT;
+  {
+    std::lock_guard<std::mutex> Lock(m_TransactionsByKeyMutex);
+    m_TransactionsByKey[MainRT->getKeyUnsafe()] = &T;
+  }
   ResourceTrackerSP ProcessRT =
       Jit->getProcessSymbolsJITDylib()->createResourceTracker();
   m_ProcessResourceTrackers[&T] = ProcessRT;
@@ -649,13 +762,19 @@ void IncrementalJIT::addModule(Transaction& T) {
 }
 
 llvm::Error IncrementalJIT::removeModule(const Transaction& T) {
-  ResourceTrackerSP MainRT = std::move(m_MainResourceTrackers[&T]);
-  if (!MainRT)
+  auto MainI = m_MainResourceTrackers.find(&T);
+  if (MainI == m_MainResourceTrackers.end())
     return llvm::Error::success();
-  ResourceTrackerSP ProcessRT = std::move(m_ProcessResourceTrackers[&T]);
-
-  m_MainResourceTrackers.erase(&T);
-  m_ProcessResourceTrackers.erase(&T);
+  ResourceTrackerSP MainRT = std::move(MainI->second);
+  auto ProcessI = m_ProcessResourceTrackers.find(&T);
+  ResourceTrackerSP ProcessRT = std::move(ProcessI->second);
+
+  m_MainResourceTrackers.erase(MainI);
+  m_ProcessResourceTrackers.erase(ProcessI);
+  {
+    std::lock_guard<std::mutex> Lock(m_TransactionsByKeyMutex);
+    m_TransactionsByKey.erase(MainRT->getKeyUnsafe());
+  }
   if (Error Err = MainRT->remove())
     return Err;
   if (Error Err = ProcessRT->remove())
@@ -667,6 +786,79 @@ llvm::Error IncrementalJIT::removeModule(const Transaction& T) {
   return llvm::Error::success();
 }
 
+llvm::Error
+IncrementalJIT::removeModules(llvm::ArrayRef<const Transaction*> Ts) {
+  ResourceTrackerSP MainRT, ProcessRT;
+  for (const Transaction* T : Ts) {
+    auto MainI = m_MainResourceTrackers.find(T);
+    if (MainI == m_MainResourceTrackers.end())
+      continue;
+    auto ProcessI = m_ProcessResourceTrackers.find(T);
+    {
+      std::lock_guard<std::mutex> Lock(m_TransactionsByKeyMutex);
+      m_TransactionsByKey.erase(MainI->second->getKeyUnsafe());
+    }
+    if (!MainRT) {
+      MainRT = std::move(MainI->second);
+      ProcessRT = std::move(ProcessI->second);
+    } else {
+      MainI->second->transferTo(*MainRT);
+      ProcessI->second->transferTo(*ProcessRT);
+    }
+    m_MainResourceTrackers.erase(MainI);
+    m_ProcessResourceTrackers.erase(ProcessI);
+
+    auto iMod = m_CompiledModules.find(T->m_CompiledModule);
+    if (iMod != m_CompiledModules.end())
+      m_CompiledModules.erase(iMod);
+  }
+
+  if (!MainRT)
+    return llvm::Error::success();
+  if (Error Err = MainRT->remove())
+    return Err;
+  return ProcessRT->remove();
+}
+
+llvm::Error
+IncrementalJIT::addReoptimizedModule(const Transaction& T,
+                                     std::unique_ptr<Module> M,
+                                     llvm::ArrayRef<std::string> Functions,
+                                     StringRef Suffix) {
+  auto MainI = m_MainResourceTrackers.find(&T);
+  if (MainI == m_MainResourceTrackers.end())
+    return make_error<StringError>("transaction has no code in the JIT",
+                                   inconvertibleErrorCode());
+  // Owned by the transaction's tracker: unloading T removes this code, too.
+  ResourceTrackerSP RT = MainI->second;
+  if (Error Err = Jit->addIRModule(
+          RT, ThreadSafeModule(std::move(M), SingleThreadedContext)))
+    return Err;
+
+  JITDylib& JD = Jit->getMainJITDylib();
+  SymbolMap Redirects;
+  for (const std::string& Name : Functions) {
+    Expected<ExecutorAddr> Addr = Jit->lookup(JD, Name + Suffix.str());
+    if (!Addr)
+      return Addr.takeError();
+    Redirects[Jit->mangleAndIntern(Name)] = {
+        *Addr, JITSymbolFlags::Exported | JITSymbolFlags::Callable};
+  }
+
+  for (auto&& Redirect : Redirects) {
+    if (Error Err = JD.remove({Redirect.first})) {
+      // The definition might come from another JITDylib; shadow it.
+      Err = handleErrors(std::move(Err),
+                         [](std::unique_ptr<SymbolsNotFound>) -> Error {
+                           return Error::success();
+                         });
+      if (Err)
+        return Err;
+    }
+  }
+  return JD.define(absoluteSymbols(std::move(Redirects)), RT);
+}
+
 orc::ExecutorAddr
 IncrementalJIT::addOrReplaceDefinition(StringRef Name,
                                        orc::ExecutorAddr KnownAddr) {
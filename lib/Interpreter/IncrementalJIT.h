@@ -10,6 +10,7 @@
 #ifndef CLING_INCREMENTAL_JIT_H
 #define CLING_INCREMENTAL_JIT_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/FunctionExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
@@ -26,6 +27,7 @@
 #include <atomic>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -83,6 +85,19 @@ public:
 
   llvm::Error removeModule(const Transaction& T);
 
+  /// Remove the code of several transactions. Their resource trackers are
+  /// merged first, so that the JIT and its memory manager are asked for a
+  /// single removal.
+  llvm::Error removeModules(llvm::ArrayRef<const Transaction*> Ts);
+
+  /// Add the re-optimized copies of Functions to the code of T, see
+  /// BackendPasses::runOnModuleWithProfile(), and resolve Functions to them
+  /// from now on. Callers linked before keep calling the previous code.
+  llvm::Error addReoptimizedModule(const Transaction& T,
+                                   std::unique_ptr<llvm::Module> M,
+                                   llvm::ArrayRef<std::string> Functions,
+                                   llvm::StringRef Suffix);
+
   /// Get the address of a symbol based on its IR name (as coming from clang's
   /// mangler). The IncludeHostSymbols parameter controls whether the lookup
   /// should include symbols from the host process (via dlsym) or not.
@@ -124,6 +139,18 @@ private:
   std::map<const Transaction*, llvm::orc::ResourceTrackerSP> m_ProcessResourceTrackers;
   std::map<const llvm::Module *, llvm::orc::ThreadSafeModule> m_CompiledModules;
 
+  /// The transactions by the key of their main resource tracker, to attribute
+  /// the emitted code and data to them.
+  std::map<llvm::orc::ResourceKey, Transaction*> m_TransactionsByKey;
+  /// Guards m_TransactionsByKey: child interpreters running on other threads
+  /// can materialize code of this JIT through their lookups.
+  std::mutex m_TransactionsByKeyMutex;
+
+  /// Add Code and Data bytes, emitted for MR, to the memory usage of the
+  /// transaction owning MR's resource tracker.
+  void recordEmittedMemory(llvm::orc::MaterializationResponsibility& MR,
+                           size_t Code, size_t Data);
+
   bool m_JITLink;
   // FIXME: Move TargetMachine ownership to BackendPasses
   std::unique_ptr<llvm::TargetMachine> m_TM;
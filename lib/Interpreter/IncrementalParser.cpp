@@ -293,7 +293,8 @@ namespace cling {
     std::unique_ptr<cling::DeclCollector> consumer;
     consumer.reset(m_Consumer = new cling::DeclCollector());
     m_CI.reset(CIFactory::createCI("\n", interp->getOptions(), llvmdir,
-                                   std::move(consumer), moduleExtensions));
+                                   std::move(consumer), moduleExtensions,
+                                   &m_RuntimePCH));
 
     if (!m_CI) {
       cling::errs() << "Compiler instance could not be created.\n";
@@ -355,9 +356,28 @@ namespace cling {
     DiagnosticsEngine& Diags = m_CI->getSema().getDiagnostics();
 
     // Pull in PCH.
-    const std::string& PCHFileName
+    std::string& PCHFileName
       = m_CI->getInvocation().getPreprocessorOpts().ImplicitPCHInclude;
-    if (!PCHFileName.empty()) {
+    if (!PCHFileName.empty() && m_RuntimePCH) {
+      // The runtime PCH is only an optimization: let the ASTReader validate
+      // it quietly and, if it is rejected, parse the runtime headers below.
+      Transaction* PchT = beginTransaction(CO);
+      const bool Suppressed = Diags.getSuppressAllDiagnostics();
+      Diags.setSuppressAllDiagnostics(true);
+      m_CI->createPCHExternalASTSource(PCHFileName,
+                                       DisableValidationForModuleKind::None,
+                                       false /*AllowPCHWithCompilerErrors*/,
+                                       nullptr /*DeserializationListener*/,
+                                       true /*OwnsDeserializationListener*/);
+      Diags.setSuppressAllDiagnostics(Suppressed);
+      result.push_back(endTransaction(PchT));
+      if (!m_CI->getASTReader()) {
+        if (m_Interpreter->getOptions().Verbose())
+          cling::log() << "Ignoring runtime PCH \"" << PCHFileName << "\"\n";
+        std::string().swap(PCHFileName);
+        m_RuntimePCH = false;
+      }
+    } else if (!PCHFileName.empty()) {
       Transaction* PchT = beginTransaction(CO);
       DiagnosticErrorTrap Trap(Diags);
       m_CI->createPCHExternalASTSource(PCHFileName,
@@ -440,6 +460,15 @@ namespace cling {
     return nullptr;
   }
 
+  void IncrementalParser::getLastTransactions(unsigned N,
+                              llvm::SmallVectorImpl<Transaction*>& Out) const {
+    if (m_Transactions.empty())
+      return;
+    for (auto I = m_Transactions.rbegin(), E = m_Transactions.rend() - 1;
+         I != E && N; ++I, --N)
+      Out.push_back(*I);
+  }
+
   const Transaction* IncrementalParser::getCurrentTransaction() const {
     return m_Consumer->getTransaction();
   }
@@ -479,6 +508,7 @@ namespace cling {
     if (!T->isNestedTransaction() && T != getLastTransaction()) {
       if (getLastTransaction())
         m_Transactions.back()->setNext(T);
+      T->setSerial(++m_LastTransactionSerial);
       m_Transactions.push_back(T);
     }
   }
@@ -498,6 +528,7 @@ namespace cling {
     }
 
     m_Consumer->setTransaction(NewCurT);
+    m_MemoryAtBegin[NewCurT] = getASTAndSourceBytes();
     return NewCurT;
   }
 
@@ -544,6 +575,7 @@ namespace cling {
       else
         m_Consumer->setTransaction((Transaction*)0);
 
+      m_MemoryAtBegin.erase(T);
       m_TransactionPool->releaseTransaction(T);
       return ParseResultTransaction(nullptr, ParseResult);
     }
@@ -690,15 +722,61 @@ namespace cling {
       m_Consumer->setTransaction(prevConsumerT);
     }
     T->setState(Transaction::kCommitted);
+    ++m_Generation;
 
     {
       Transaction* prevConsumerT = m_Consumer->getTransaction();
+      recordMemoryUsage(*T);
       if (InterpreterCallbacks* callbacks = m_Interpreter->getCallbacks())
         callbacks->TransactionCommitted(*T);
       m_Consumer->setTransaction(prevConsumerT);
     }
   }
 
+  std::pair<size_t, size_t> IncrementalParser::getASTAndSourceBytes() const {
+    const ASTContext& C = m_CI->getASTContext();
+    const SourceManager& SM = m_CI->getSourceManager();
+    SourceManager::MemoryBufferSizes Buffers = SM.getMemoryBufferSizes();
+    return {C.getASTAllocatedMemory() + C.getSideTableAllocatedMemory(),
+            Buffers.malloc_bytes + Buffers.mmap_bytes
+            + SM.getDataStructureSizes()};
+  }
+
+  void IncrementalParser::recordMemoryUsage(Transaction& T) {
+    auto I = m_MemoryAtBegin.find(&T);
+    if (I == m_MemoryAtBegin.end())
+      return;
+    std::pair<size_t, size_t> Now = getASTAndSourceBytes();
+    Transaction::MemoryUsage& Usage = T.getMemoryUsage();
+    // Unloading a transaction meanwhile might have shrunk the allocations.
+    Usage.AST = Now.first > I->second.first ? Now.first - I->second.first : 0;
+    Usage.SourceManager
+      = Now.second > I->second.second ? Now.second - I->second.second : 0;
+    m_MemoryAtBegin.erase(I);
+
+    if (InterpreterCallbacks* callbacks = m_Interpreter->getCallbacks())
+      callbacks->TransactionMemoryAccounted(T);
+  }
+
+  ///\brief Estimate the memory held by M from the sizes of its IR objects.
+  ///
+  static size_t estimateModuleSize(const llvm::Module& M) {
+    size_t Size = sizeof(llvm::Module);
+    for (const llvm::GlobalVariable& GV : M.globals())
+      Size += sizeof(llvm::GlobalVariable)
+        + GV.getNumOperands() * sizeof(llvm::Use);
+    for (const llvm::Function& F : M) {
+      Size += sizeof(llvm::Function) + F.arg_size() * sizeof(llvm::Argument);
+      for (const llvm::BasicBlock& BB : F) {
+        Size += sizeof(llvm::BasicBlock);
+        for (const llvm::Instruction& I : BB)
+          Size += sizeof(llvm::Instruction)
+            + I.getNumOperands() * sizeof(llvm::Use);
+      }
+    }
+    return Size;
+  }
+
   void IncrementalParser::emitTransaction(Transaction* T) {
     for (auto DI = T->decls_begin(), DE = T->decls_end(); DI != DE; ++DI)
       m_Consumer->HandleTopLevelDecl(DI->m_DGR);
@@ -745,8 +823,10 @@ namespace cling {
 
       std::unique_ptr<llvm::Module> M(getCodeGenerator()->ReleaseModule());
 
-      if (M)
+      if (M) {
+        T->getMemoryUsage().Module = estimateModuleSize(*M);
         T->setModule(std::move(M));
+      }
 
       if (T->getIssuedDiags() != Transaction::kNone) {
         // Module has been released from Codegen, reset the Diags now.
@@ -764,6 +844,8 @@ namespace cling {
   }
 
   void IncrementalParser::deregisterTransaction(Transaction& T) {
+    m_MemoryAtBegin.erase(&T);
+    ++m_Generation;
     if (&T == m_Consumer->getTransaction())
       m_Consumer->setTransaction(T.getParent());
 
@@ -1018,6 +1100,10 @@ namespace cling {
     }
   }
 
+  void IncrementalParser::printTransformerStats(llvm::raw_ostream& Out) const {
+    m_Consumer->printTransformerStats(Out);
+  }
+
   void IncrementalParser::SetTransformers(bool isChildInterpreter) {
     // Add transformers to the IncrementalParser, which owns them
     Sema* TheSema = &m_CI->getSema();
@@ -12,6 +12,7 @@
 
 #include "clang/Basic/SourceLocation.h"
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
@@ -25,6 +26,7 @@ namespace llvm {
   struct GenericValue;
   class MemoryBuffer;
   class Module;
+  class raw_ostream;
 }
 
 namespace clang {
@@ -62,6 +64,10 @@ namespace cling {
     // compiler instance.
     std::unique_ptr<clang::CompilerInstance> m_CI;
 
+    ///\brief Whether the implicit PCH is the prebuilt runtime PCH.
+    ///
+    bool m_RuntimePCH = false;
+
     // parser (incremental)
     std::unique_ptr<clang::Parser> m_Parser;
 
@@ -89,6 +95,19 @@ namespace cling {
     ///\brief Number of created modules.
     unsigned m_ModuleNo = 0;
 
+    ///\brief The serial number given to the last transaction added to
+    /// m_Transactions.
+    unsigned long long m_LastTransactionSerial = 0;
+
+    ///\brief Incremented whenever a transaction is committed or deregistered.
+    unsigned long long m_Generation = 0;
+
+    ///\brief Bytes allocated by the ASTContext and the SourceManager when a
+    /// transaction began; their growth is attributed to it on commit.
+    ///
+    llvm::DenseMap<const Transaction*, std::pair<size_t, size_t>>
+      m_MemoryAtBegin;
+
     ///\brief Code generator
     ///
     clang::CodeGenerator* m_CodeGen = nullptr;
@@ -126,6 +145,11 @@ namespace cling {
                     bool isChildInterpreter);
     clang::CompilerInstance* getCI() const { return m_CI.get(); }
     clang::Parser* getParser() const { return m_Parser.get(); }
+
+    ///\brief Returns a counter that changes whenever the set of committed
+    /// transactions changes.
+    ///
+    unsigned long long getGeneration() const { return m_Generation; }
     clang::CodeGenerator* getCodeGenerator() const { return m_CodeGen; }
     bool hasCodeGenerator() const { return m_CodeGen; }
 
@@ -195,11 +219,28 @@ namespace cling {
       return m_Transactions.back();
     }
 
+    ///\brief Returns the number of transactions the incremental parser saw,
+    /// i.e. the length of the chain starting at getFirstTransaction().
+    ///
+    size_t getNumTransactions() const { return m_Transactions.size(); }
+
+    ///\brief Returns the transaction at position Idx of the chain.
+    ///
+    const Transaction* getTransaction(size_t Idx) const {
+      return m_Transactions[Idx];
+    }
+
     ///\brief Returns the most recent transaction with an input line wrapper,
     /// which could well be the current one.
     ///
     const Transaction* getLastWrapperTransaction() const;
 
+    ///\brief Collects up to N of the most recent transactions, newest first.
+    /// The first transaction is never collected.
+    ///
+    void getLastTransactions(unsigned N,
+                             llvm::SmallVectorImpl<Transaction*>& Out) const;
+
     ///\brief Returns the currently active transaction.
     ///
     const Transaction* getCurrentTransaction() const;
@@ -226,6 +267,10 @@ namespace cling {
 
     void printTransactionStructure() const;
 
+    ///\brief Prints the time spent in each AST transformer.
+    ///
+    void printTransformerStats(llvm::raw_ostream& Out) const;
+
     ///\brief Runs the static initializers created by codegening a transaction.
     ///
     ///\param[in] T - the transaction for which to run the initializers.
@@ -264,6 +309,16 @@ namespace cling {
     ///
     llvm::Module* StartModule();
 
+    ///\brief Bytes currently allocated by the ASTContext and the
+    /// SourceManager.
+    ///
+    std::pair<size_t, size_t> getASTAndSourceBytes() const;
+
+    ///\brief Attribute the AST and SourceManager growth since T began to T
+    /// and report T's memory usage to the callbacks.
+    ///
+    void recordMemoryUsage(Transaction& T);
+
   };
 } // end namespace cling
 #endif // CLING_INCREMENTAL_PARSER_H
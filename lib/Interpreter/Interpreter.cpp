@@ -14,6 +14,7 @@
 #endif
 #include "ClingUtils.h"
 
+#include "AutoloadIndex.h"
 #include "DynamicLookup.h"
 #include "EnterUserCodeRAII.h"
 #include "ExternalInterpreterSource.h"
@@ -57,10 +58,15 @@
 #include "clang/Sema/Sema.h"
 #include "clang/Sema/SemaDiagnostic.h"
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -96,8 +102,70 @@ namespace {
 
 namespace cling {
 
+  namespace {
+    struct HeldQueryLock {
+      const Interpreter* Interp;
+      bool Exclusive;
+    };
+    // The interpreters whose query lock the current thread holds.
+    thread_local llvm::SmallVector<HeldQueryLock, 2> tHeldQueryLocks;
+
+    HeldQueryLock* findHeldQueryLock(const Interpreter* I) {
+      for (HeldQueryLock& H : tHeldQueryLocks)
+        if (H.Interp == I)
+          return &H;
+      return nullptr;
+    }
+  } // unnamed namespace
+
+  Interpreter::QueryLockRAII::QueryLockRAII(const Interpreter& I,
+                                            bool Exclusive) {
+    if (!I.m_ConcurrentQueries)
+      return;
+    if (HeldQueryLock* H = findHeldQueryLock(&I)) {
+      if (H->Exclusive || !Exclusive)
+        return;
+      // A shared lock cannot be upgraded in place; whatever the reader saw
+      // before might change while it is not held.
+      I.m_QueryLock.unlock_shared();
+      I.m_QueryLock.lock();
+      H->Exclusive = true;
+      m_Upgraded = true;
+    } else {
+      if (Exclusive)
+        I.m_QueryLock.lock();
+      else
+        I.m_QueryLock.lock_shared();
+      tHeldQueryLocks.push_back({&I, Exclusive});
+    }
+    m_Interpreter = &I;
+    m_Exclusive = Exclusive;
+  }
+
+  Interpreter::QueryLockRAII::~QueryLockRAII() {
+    if (!m_Interpreter)
+      return;
+    HeldQueryLock* H = findHeldQueryLock(m_Interpreter);
+    assert(H && "Query lock released behind our back");
+    if (m_Upgraded) {
+      m_Interpreter->m_QueryLock.unlock();
+      m_Interpreter->m_QueryLock.lock_shared();
+      H->Exclusive = false;
+      return;
+    }
+    if (m_Exclusive)
+      m_Interpreter->m_QueryLock.unlock();
+    else
+      m_Interpreter->m_QueryLock.unlock_shared();
+    tHeldQueryLocks.erase(H);
+  }
+
+  unsigned long long Interpreter::getStateGeneration() const {
+    return m_IncrParser->getGeneration();
+  }
+
   Interpreter::PushTransactionRAII::PushTransactionRAII(const Interpreter* i)
-    : m_Interpreter(i) {
+    : m_Lock(*i, /*Exclusive=*/true), m_Interpreter(i) {
     CompilationOptions CO = m_Interpreter->makeDefaultCompilationOpts();
     CO.ResultEvaluation = 0;
     CO.DynamicScoping = 0;
@@ -195,17 +263,19 @@ namespace cling {
     bool showSuggestions =
         !llvm::StringRef(ClingStringify(CLING_VERSION)).starts_with("ROOT");
 
-    std::unique_ptr<InterpreterCallbacks> AutoLoadCB(
+    std::unique_ptr<AutoloadCallback> AutoLoadCB(
         new AutoloadCallback(&Interp, showSuggestions));
+    for (const std::string& Index : Interp.getOptions().AutoloadIndexes)
+      AutoLoadCB->loadIndex(Index);
     Interp.setCallbacks(std::move(AutoLoadCB));
   }
 
-  Interpreter::Interpreter(int argc, const char* const *argv,
+  Interpreter::Interpreter(const InvocationOptions& Opts,
                            const char* llvmdir /*= 0*/,
                            const ModuleFileExtensions& moduleExtensions,
                            void *extraLibHandle, bool noRuntime,
                            const Interpreter* parentInterp) :
-    m_Opts(argc, argv),
+    m_Opts(Opts),
     m_UniqueCounter(parentInterp ? parentInterp->m_UniqueCounter + 1 : 0),
     m_PrintDebug(false), m_DynamicLookupDeclared(false),
     m_DynamicLookupEnabled(false), m_RawInputEnabled(false),
@@ -215,6 +285,10 @@ namespace cling {
     if (handleSimpleOptions(m_Opts))
       return;
 
+    // The runtime PCH only makes sense for interpreters that get the runtime.
+    if (noRuntime || parentInterp)
+      m_Opts.RuntimePCH = false;
+
     auto LLVMCtx = std::make_unique<llvm::LLVMContext>();
     TSCtx = std::make_unique<llvm::orc::ThreadSafeContext>(std::move(LLVMCtx));
     m_IncrParser.reset(new IncrementalParser(this, llvmdir, moduleExtensions));
@@ -255,7 +329,8 @@ namespace cling {
       llvm::sys::fs::create_directory(TmpFolder);
 
       // The CUDA fatbin file is the connection beetween the CUDA device
-      // compiler and the CodeGen of cling. The file will every time reused.
+      // compiler and the CodeGen of cling. It only exists in memory, in the
+      // virtual file system of the CompilerInstance.
       if (getCI()->getCodeGenOpts().CudaGpuBinaryFileName.empty())
         getCI()->getCodeGenOpts().CudaGpuBinaryFileName
           = std::string(TmpFolder.c_str()) + "cling.fatbin";
@@ -350,8 +425,8 @@ namespace cling {
                            const char* llvmdir /*= 0*/,
                            const ModuleFileExtensions& moduleExtensions/*={}*/,
                            void *ExtraLibHandle, bool noRuntime /*= true*/) :
-    Interpreter(argc, argv, llvmdir, moduleExtensions, ExtraLibHandle, noRuntime,
-                &parentInterpreter) {
+    Interpreter(InvocationOptions(argc, argv), llvmdir, moduleExtensions,
+                ExtraLibHandle, noRuntime, &parentInterpreter) {
     // Do the "setup" of the connection between this interpreter and
     // its parent interpreter.
     if (CompilerInstance* CI = getCIOrNull()) {
@@ -667,6 +742,54 @@ namespace cling {
       DLM->dump(S);
   }
 
+  ///\brief Print the N top-level transactions that caused the most memory,
+  /// followed by the sum over all transactions.
+  static void printMemoryUsage(llvm::raw_ostream& Out, const Transaction* T,
+                               const SourceManager& SM, unsigned N) {
+    std::vector<const Transaction*> Transactions;
+    Transaction::MemoryUsage Sum;
+    for (; T; T = T->getNext()) {
+      Transactions.push_back(T);
+      const Transaction::MemoryUsage& U = T->getMemoryUsage();
+      Sum.AST += U.AST;
+      Sum.SourceManager += U.SourceManager;
+      Sum.Module += U.Module;
+      Sum.JITCode += U.JITCode;
+      Sum.JITData += U.JITData;
+      Sum.AtExit += U.AtExit;
+    }
+    std::stable_sort(Transactions.begin(), Transactions.end(),
+                     [](const Transaction* L, const Transaction* R) {
+                       return L->getMemoryUsage().total()
+                         > R->getMemoryUsage().total();
+                     });
+
+    auto printRow = [&Out](llvm::StringRef Name,
+                           const Transaction::MemoryUsage& U,
+                           llvm::StringRef Origin) {
+      Out << llvm::format("%-8s %12zu %12zu %10zu %10zu %10zu %10zu %8zu  ",
+                          Name.str().c_str(), U.total(), U.AST,
+                          U.SourceManager, U.Module, U.JITCode, U.JITData,
+                          U.AtExit)
+          << Origin << "\n";
+    };
+
+    Out << llvm::format("%-8s %12s %12s %10s %10s %10s %10s %8s  %s\n",
+                        "ID", "total", "AST", "source", "module", "JIT code",
+                        "JIT data", "atexit", "origin");
+    for (const Transaction* I : llvm::ArrayRef(Transactions).take_front(N)) {
+      std::string Origin;
+      SourceLocation Loc = I->getSourceStart(SM);
+      if (Loc.isValid()) {
+        PresumedLoc PLoc = SM.getPresumedLoc(Loc);
+        if (PLoc.isValid())
+          Origin = PLoc.getFilename();
+      }
+      printRow(std::to_string(I->getUniqueID()), I->getMemoryUsage(), Origin);
+    }
+    printRow("all", Sum, std::to_string(Transactions.size()) + " transactions");
+  }
+
   // FIXME: Add stream argument and move DumpIncludePath path here.
   void Interpreter::dump(llvm::StringRef what, llvm::StringRef filter) {
     llvm::raw_ostream &where = cling::log();
@@ -687,6 +810,16 @@ namespace cling {
       ClangInternalState::printLookupTables(where, getSema().getASTContext());
     else if (what.equals("undo"))
       m_IncrParser->printTransactionStructure();
+    else if (what.equals("transformers"))
+      m_IncrParser->printTransformerStats(where);
+    else if (what.equals("memory")) {
+      unsigned N = 10;
+      if (!filter.empty() && filter.getAsInteger(10, N))
+        cling::errs() << "Invalid number of transactions '" << filter << "'\n";
+      else
+        printMemoryUsage(where, getFirstTransaction(),
+                         getCI()->getSourceManager(), N);
+    }
   }
 
   void Interpreter::storeInterpreterState(const std::string& name) const {
@@ -779,6 +912,7 @@ namespace cling {
     CO.IgnorePromptDiags = 0;
     CO.CheckPointerValidity = !isRawInputEnabled();
     CO.OptLevel = getDefaultOptLevel();
+    CO.BorrowResults = m_RuntimeOptions.BorrowResults;
     return CO;
   }
 
@@ -820,6 +954,7 @@ namespace cling {
   Interpreter::process(const std::string& input, Value* V /* = 0 */,
                        Transaction** T /* = 0 */,
                        bool disableValuePrinting /* = false*/) {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
     if (!isInSyntaxOnlyMode() && m_Opts.CompilerOpts.CUDAHost)
       m_CUDACompiler->process(input);
 
@@ -854,6 +989,7 @@ namespace cling {
 
   Interpreter::CompilationResult
   Interpreter::parse(const std::string& input, Transaction** T /*=0*/) const {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
     if (!isInSyntaxOnlyMode() && m_Opts.CompilerOpts.CUDAHost)
       m_CUDACompiler->parse(input);
     CompilationOptions CO = makeDefaultCompilationOpts();
@@ -989,6 +1125,7 @@ namespace cling {
 
   Interpreter::CompilationResult
   Interpreter::declare(const std::string& input, Transaction** T/*=0 */) {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
     if (!isInSyntaxOnlyMode() && m_Opts.CompilerOpts.CUDAHost)
       m_CUDACompiler->declare(input);
 
@@ -1310,6 +1447,8 @@ namespace cling {
     if (isInSyntaxOnlyMode())
       return nullptr;
 
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
+
     if (ifUnique) {
       if (void* Addr = (void*)getAddressOfGlobal(name)) {
         return Addr;
@@ -1363,6 +1502,7 @@ namespace cling {
            && CO.ResultEvaluation == 0
            && "Compilation Options not compatible with \"declare\" mode.");
 
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
     StateDebuggerRAII stateDebugger(this);
 
     IncrementalParser::ParseResultTransaction PRT
@@ -1381,6 +1521,7 @@ namespace cling {
                                 Value* V, /* = 0 */
                                 Transaction** /* T = 0 */,
                                 size_t wrapPoint /* = 0*/) {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
     StateDebuggerRAII stateDebugger(this);
 
     // Wrap the expression
@@ -1471,6 +1612,7 @@ namespace cling {
 
   Interpreter::CompilationResult
   Interpreter::loadLibrary(const std::string& filename, bool lookup) {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
     DynamicLibraryManager* DLM = getDynamicLibraryManager();
     std::string canonicalLib;
     if (lookup)
@@ -1508,14 +1650,19 @@ namespace cling {
     return res;
   }
 
-  void Interpreter::unload(Transaction& T) {
-    T.setUnloading();
-    // Clear any stored states that reference the llvm::Module.
+  void Interpreter::prepareUnload(llvm::ArrayRef<Transaction*> Ts) {
+    llvm::SmallPtrSet<const llvm::Module*, 8> Modules;
+    for (Transaction* T : Ts) {
+      T->setUnloading();
+      if (const auto *Module = T->getCompiledModule())
+        Modules.insert(Module);
+    }
+
+    // Clear any stored states that reference the llvm::Modules.
     // Do it first in case
-    const auto *Module = T.getCompiledModule();
-    if (Module && !m_StoredStates.empty()) {
-      const auto Predicate = [&Module](const ClangInternalState* S) {
-        return S->getModule() == Module;
+    if (!Modules.empty() && !m_StoredStates.empty()) {
+      const auto Predicate = [&Modules](const ClangInternalState* S) {
+        return Modules.count(S->getModule());
       };
       auto Itr =
           std::find_if(m_StoredStates.begin(), m_StoredStates.end(), Predicate);
@@ -1524,26 +1671,29 @@ namespace cling {
           cling::errs() << "Unloading Transaction forced state '"
                         << (*Itr)->getName() << "' to be destroyed\n";
         }
-        m_StoredStates.erase(Itr);
-
-        Itr = std::find_if(m_StoredStates.begin(), m_StoredStates.end(),
-                           Predicate);
+        Itr = m_StoredStates.erase(Itr);
+        Itr = std::find_if(Itr, m_StoredStates.end(), Predicate);
       }
     }
 
-    // Clear any cached transaction states.
-    for (unsigned i = 0; i < kNumTransactions; ++i) {
-      if (m_CachedTrns[i] == &T) {
-        m_CachedTrns[i] = nullptr;
-        break;
+    for (Transaction* T : Ts) {
+      // Clear any cached transaction states.
+      for (unsigned i = 0; i < kNumTransactions; ++i) {
+        if (m_CachedTrns[i] == T) {
+          m_CachedTrns[i] = nullptr;
+          break;
+        }
       }
-    }
 
-    if (InterpreterCallbacks* callbacks = getCallbacks())
-      callbacks->TransactionUnloaded(T);
-    if (m_Executor) // we also might be in fsyntax-only mode.
-      m_Executor->runAndRemoveStaticDestructors(&T);
+      if (InterpreterCallbacks* callbacks = getCallbacks())
+        callbacks->TransactionUnloaded(*T);
+      if (m_Executor) // we also might be in fsyntax-only mode.
+        m_Executor->runAndRemoveStaticDestructors(T);
+    }
+  }
 
+  void Interpreter::revertAndDeregister(Transaction& T,
+                                        TransactionUnloader& U) {
     // We can revert the most recent transaction or a nested transaction of a
     // transaction that is not in the middle of the transaction collection
     // (i.e. at the end or not yet added to the collection at all).
@@ -1552,18 +1702,10 @@ namespace cling {
     assert((T.getState() != Transaction::kRolledBack ||
             T.getState() != Transaction::kRolledBackWithErrors) &&
            "Transaction already rolled back.");
-    if (getOptions().ErrorOut) {
-      // Tag the transaction as "won't need to be committed" (ROOT-10798).
-      T.setState(Transaction::kRolledBack);
-      return;
-    }
 
     if (InterpreterCallbacks* callbacks = getCallbacks())
       callbacks->TransactionRollback(T);
 
-    TransactionUnloader U(this, &getCI()->getSema(),
-                          m_IncrParser->getCodeGenerator(),
-                          m_Executor.get());
     if (U.RevertTransaction(&T))
       T.setState(Transaction::kRolledBack);
     else
@@ -1572,21 +1714,114 @@ namespace cling {
     m_IncrParser->deregisterTransaction(T);
   }
 
+  void Interpreter::unload(Transaction& T) {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
+    // A nested transaction reached while unloading a batch: everything but
+    // its declarations is already gone.
+    if (m_BatchUnloader && m_BatchUnloader->isInBatch(&T)) {
+      revertAndDeregister(T, *m_BatchUnloader);
+      return;
+    }
+
+    Transaction* Ts[] = {&T};
+    prepareUnload(Ts);
+
+    if (getOptions().ErrorOut) {
+      // Tag the transaction as "won't need to be committed" (ROOT-10798).
+      T.setState(Transaction::kRolledBack);
+      return;
+    }
+
+    TransactionUnloader U(this, &getCI()->getSema(),
+                          m_IncrParser->getCodeGenerator(),
+                          m_Executor.get());
+    revertAndDeregister(T, U);
+  }
+
+  static void collectNestedTransactions(Transaction* T,
+                                  llvm::SmallVectorImpl<Transaction*>& Out) {
+    Out.push_back(T);
+    for (auto I = T->nested_begin(), E = T->nested_end(); I != E; ++I)
+      collectNestedTransactions(*I, Out);
+  }
+
+  void Interpreter::unloadTransactions(llvm::ArrayRef<Transaction*> Ts) {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
+    // Parents before their nested transactions, like the recursion in
+    // TransactionUnloader would visit them.
+    llvm::SmallVector<Transaction*, 64> All;
+    for (Transaction* T : Ts)
+      collectNestedTransactions(T, All);
+
+    prepareUnload(All);
+
+    if (getOptions().ErrorOut) {
+      // Tag the transactions as "won't need to be committed" (ROOT-10798).
+      for (Transaction* T : Ts)
+        T->setState(Transaction::kRolledBack);
+      return;
+    }
+
+    TransactionUnloader U(this, &getCI()->getSema(),
+                          m_IncrParser->getCodeGenerator(),
+                          m_Executor.get());
+    U.beginBatch(All);
+    assert(!m_BatchUnloader && "Recursive batch unloading");
+    m_BatchUnloader = &U;
+    for (Transaction* T : Ts)
+      revertAndDeregister(*T, U);
+    m_BatchUnloader = nullptr;
+    U.endBatch();
+  }
+
   void Interpreter::unload(unsigned numberOfTransactions) {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
     const Transaction *First = m_IncrParser->getFirstTransaction();
     if (!First) {
       cling::errs() << "cling: No transactions to unload!";
       return;
     }
-    for (unsigned i = 0; i < numberOfTransactions; ++i) {
-      cling::Transaction* T = m_IncrParser->getLastTransaction();
-      if (T == First) {
-        cling::errs() << "cling: Can't unload first transaction!  Unloaded "
-                      << i << " of " << numberOfTransactions << "\n";
-        return;
-      }
-      unload(*T);
+    llvm::SmallVector<Transaction*, 8> Ts;
+    m_IncrParser->getLastTransactions(numberOfTransactions, Ts);
+    if (Ts.size() == 1)
+      unload(*Ts.front());
+    else if (!Ts.empty())
+      unloadTransactions(Ts);
+
+    if (Ts.size() < numberOfTransactions) {
+      cling::errs() << "cling: Can't unload first transaction!  Unloaded "
+                    << Ts.size() << " of " << numberOfTransactions << "\n";
+    }
+  }
+
+  Interpreter::Checkpoint Interpreter::checkpoint() const {
+    QueryLockRAII Lock(*this, /*Exclusive=*/false);
+    Checkpoint C;
+    if (const Transaction* Last = m_IncrParser->getLastTransaction()) {
+      C.m_Serial = Last->getSerial();
+      C.m_NumTransactions = m_IncrParser->getNumTransactions();
     }
+    return C;
+  }
+
+  bool Interpreter::restore(const Checkpoint& C) {
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
+    const size_t NumTransactions = m_IncrParser->getNumTransactions();
+    if (!C.isValid() || NumTransactions < C.m_NumTransactions
+        || m_IncrParser->getTransaction(C.m_NumTransactions - 1)->getSerial()
+           != C.m_Serial)
+      return false;
+    if (NumTransactions == C.m_NumTransactions)
+      return true;
+
+    llvm::SmallVector<Transaction*, 8> Ts;
+    m_IncrParser->getLastTransactions(NumTransactions - C.m_NumTransactions,
+                                      Ts);
+    if (Ts.size() == 1)
+      unload(*Ts.front());
+    else
+      unloadTransactions(Ts);
+    return m_IncrParser->getNumTransactions() == C.m_NumTransactions;
   }
 
   Interpreter::CompilationResult
@@ -1686,6 +1921,27 @@ namespace cling {
                                              this)->getDynamicLibraryManager());
   }
 
+  void Interpreter::enableProfileInstrumentation(bool value /*=true*/) {
+    if (m_Executor)
+      m_Executor->enableProfileInstrumentation(value);
+  }
+
+  bool Interpreter::isProfileInstrumentationEnabled() const {
+    return m_Executor && m_Executor->isProfileInstrumentationEnabled();
+  }
+
+  unsigned Interpreter::reoptimizeWithProfile(llvm::StringRef Function,
+                                              const Transaction* T) {
+    if (!m_Executor)
+      return 0;
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
+    return m_Executor->reoptimizeWithProfile(Function, T);
+  }
+
+  bool Interpreter::writeProfile(llvm::StringRef FileName) const {
+    return m_Executor && m_Executor->writeProfile(FileName);
+  }
+
   const Transaction* Interpreter::getFirstTransaction() const {
     return m_IncrParser->getFirstTransaction();
   }
@@ -1743,6 +1999,8 @@ namespace cling {
   void* Interpreter::getAddressOfGlobal(const GlobalDecl& GD,
                                         bool* fromJIT /*=0*/) const {
     // Return a symbol's address, and whether it was jitted.
+    // Mangling can instantiate and deserialize.
+    QueryLockRAII Lock(*this, /*Exclusive=*/true);
     std::string mangledName;
     utils::Analyze::maybeMangleDeclName(GD, mangledName);
 #if defined(_WIN32)
@@ -1768,6 +2026,7 @@ namespace cling {
     // Return a symbol's address, and whether it was jitted.
     if (isInSyntaxOnlyMode())
       return nullptr;
+    QueryLockRAII Lock(*this, /*Exclusive=*/false);
     return m_Executor->getAddressOfGlobal(SymName, fromJIT);
   }
 
@@ -1829,6 +2088,86 @@ namespace cling {
                    &log);
   }
 
+  ///\brief Records the names declared by D, and by the namespaces it opens,
+  /// in the autoload index W.
+  static void addToAutoloadIndex(const Decl* D, const SourceManager& SM,
+                                 AutoloadIndexWriter& W,
+                                 llvm::StringRef Header,
+                                 llvm::StringRef Library) {
+    if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D)) {
+      for (const Decl* Sub : cast<DeclContext>(D)->decls())
+        addToAutoloadIndex(Sub, SM, W, Header, Library);
+      return;
+    }
+
+    const NamedDecl* ND = dyn_cast<NamedDecl>(D);
+    if (!ND || !ND->getIdentifier() || ND->isInAnonymousNamespace() ||
+        SM.isInSystemHeader(ND->getLocation()))
+      return;
+
+    if (isa<TagDecl>(ND) || isa<TypedefNameDecl>(ND) ||
+        isa<RedeclarableTemplateDecl>(ND) || isa<FunctionDecl>(ND) ||
+        isa<VarDecl>(ND))
+      W.add(ND->getQualifiedNameAsString(), Header, Library);
+  }
+
+  bool Interpreter::GenerateAutoloadIndex(llvm::ArrayRef<std::string> inFiles,
+                                          llvm::StringRef outFile,
+                                          llvm::StringRef library) {
+    // One generator serves all the headers: their common dependencies are
+    // parsed once, and a name is attributed to the first header exposing it.
+    const char *const dummy="cling_fwd_declarator";
+    // FIXME: CIFactory appends extra 3 folders to the llvmdir.
+    std::string llvmdir
+      = getCI()->getHeaderSearchOpts().ResourceDir + "/../../../";
+    cling::Interpreter idxGen(1, &dummy, llvmdir.c_str(),
+                              /*moduleExtensions*/ {},
+                              /*ExtraLibHandle*/ nullptr, /*noRuntime=*/true);
+
+    Preprocessor& idxGenPP = idxGen.getCI()->getPreprocessor();
+    HeaderSearchOptions headerOpts = getCI()->getHeaderSearchOpts();
+    clang::ApplyHeaderSearchOptions(idxGenPP.getHeaderSearchInfo(), headerOpts,
+                                    idxGenPP.getLangOpts(),
+                                    idxGenPP.getTargetInfo().getTriple());
+
+    CompilationOptions CO = makeDefaultCompilationOpts();
+    CO.DeclarationExtraction = 0;
+    CO.ValuePrinting = 0;
+    CO.ResultEvaluation = 0;
+    CO.DynamicScoping = 0;
+    CO.CodeGeneration = 0;
+
+    AutoloadIndexWriter Writer;
+    const SourceManager& SM = idxGen.getCI()->getSourceManager();
+    for (const std::string& inFile : inFiles) {
+      std::string includeFile = "#include \"" + inFile + "\"";
+      IncrementalParser::ParseResultTransaction PRT
+        = idxGen.m_IncrParser->Compile(includeFile, CO);
+      if (PRT.getInt() == IncrementalParser::kFailed) {
+        cling::errs() << "Error in cling::Interpreter::GenerateAutoloadIndex:\n"
+                         "   Failed to parse " << inFile << "\n";
+        continue;
+      }
+      // If this was already #included we will get a T == 0.
+      Transaction* T = PRT.getPointer();
+      if (!T)
+        continue;
+      for (auto I = T->decls_begin(), E = T->decls_end(); I != E; ++I) {
+        if (I->m_Call != Transaction::kCCIHandleTopLevelDecl)
+          continue;
+        for (const Decl* D : I->m_DGR)
+          addToAutoloadIndex(D, SM, Writer, inFile, library);
+      }
+    }
+
+    if (llvm::Error Err = Writer.write(outFile)) {
+      llvm::logAllUnhandledErrors(std::move(Err), cling::errs(),
+                     "Error in cling::Interpreter::GenerateAutoloadIndex: ");
+      return false;
+    }
+    return true;
+  }
+
   void Interpreter::forwardDeclare(Transaction& T, Preprocessor& P,
                                    clang::ASTContext& Ctx,
                                    llvm::raw_ostream& out,
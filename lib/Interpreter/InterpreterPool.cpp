@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+// CLING - the C++ LLVM-based InterpreterG :)
+//
+// This file is dual-licensed: you can choose to license it under the University
+// of Illinois Open Source License or the GNU Lesser General Public License. See
+// LICENSE.TXT for details.
+//------------------------------------------------------------------------------
+
+#include "cling/Interpreter/InterpreterPool.h"
+
+#include "cling/Utils/Output.h"
+
+#include <cassert>
+
+namespace cling {
+
+  InterpreterPool::Lease&
+  InterpreterPool::Lease::operator=(Lease&& Other) {
+    if (this != &Other) {
+      release();
+      m_Pool = Other.m_Pool;
+      m_Entry = std::move(Other.m_Entry);
+    }
+    return *this;
+  }
+
+  void InterpreterPool::Lease::release() {
+    if (m_Entry)
+      m_Pool->giveBack(std::move(m_Entry));
+  }
+
+  InterpreterPool::InterpreterPool(Interpreter& Parent, unsigned Size,
+                                   int argc, const char* const* argv,
+                                   const char* llvmdir /*= LLVM_PATH*/,
+                                   llvm::StringRef Prologue /*= {}*/)
+    : m_Parent(Parent), m_Size(Size), m_LLVMDir(llvmdir ? llvmdir : ""),
+      m_HasLLVMDir(llvmdir), m_Args(argv, argv + argc),
+      m_Prologue(Prologue.str()) {
+    // The children import from the parent on their own threads.
+    m_Parent.enableConcurrentQueries();
+
+    m_Free.reserve(Size);
+    for (unsigned i = 0; i < Size; ++i)
+      m_Free.push_back(createChild());
+  }
+
+  InterpreterPool::~InterpreterPool() {
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    assert(m_Free.size() == m_Size && "Pool destroyed with leased children");
+  }
+
+  std::unique_ptr<InterpreterPool::Entry>
+  InterpreterPool::createChild() const {
+    std::vector<const char*> Argv;
+    Argv.reserve(m_Args.size());
+    for (const std::string& Arg : m_Args)
+      Argv.push_back(Arg.c_str());
+
+    auto E = std::make_unique<Entry>();
+    {
+      // Setting up the child reads the parent's AST and JIT.
+      Interpreter::QueryLockRAII ParentLock(m_Parent, /*Exclusive=*/true);
+      E->Interp.reset(new Interpreter(m_Parent, Argv.size(), Argv.data(),
+                                      m_HasLLVMDir ? m_LLVMDir.c_str()
+                                                   : nullptr));
+    }
+    if (!m_Prologue.empty() &&
+        E->Interp->declare(m_Prologue) != Interpreter::kSuccess)
+      cling::errs() << "cling::InterpreterPool: prologue failed to compile\n";
+    E->Checkpoint = E->Interp->checkpoint();
+    return E;
+  }
+
+  void InterpreterPool::rollback(Entry& E) const {
+    if (!E.Interp->restore(E.Checkpoint))
+      E = std::move(*createChild());
+  }
+
+  void InterpreterPool::giveBack(std::unique_ptr<Entry> E) {
+    // Roll back outside of the pool lock, other children stay available.
+    rollback(*E);
+    {
+      std::lock_guard<std::mutex> Lock(m_Mutex);
+      m_Free.push_back(std::move(E));
+    }
+    m_Returned.notify_one();
+  }
+
+  InterpreterPool::Lease InterpreterPool::acquire() {
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    m_Returned.wait(Lock, [this] { return !m_Free.empty(); });
+    std::unique_ptr<Entry> E = std::move(m_Free.back());
+    m_Free.pop_back();
+    return Lease(*this, std::move(E));
+  }
+
+  InterpreterPool::Lease InterpreterPool::tryAcquire() {
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    if (m_Free.empty())
+      return Lease();
+    std::unique_ptr<Entry> E = std::move(m_Free.back());
+    m_Free.pop_back();
+    return Lease(*this, std::move(E));
+  }
+
+  unsigned InterpreterPool::available() const {
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_Free.size();
+  }
+} // end namespace cling
@@ -99,6 +99,7 @@ static const char kNoStdInc[] = "-nostdinc";
     Opts.Help = Args.hasArg(OPT_help);
     Opts.NoRuntime = Args.hasArg(OPT_noruntime);
     Opts.PtrCheck = Args.hasArg(OPT__ptrcheck);
+    Opts.RuntimePCH = !Args.hasArg(OPT__noruntime_pch);
     if (Arg* MetaStringArg = Args.getLastArg(OPT__metastr, OPT__metastr_EQ)) {
       Opts.MetaString = MetaStringArg->getValue();
       if (Opts.MetaString.empty()) {
@@ -106,6 +107,9 @@ static const char kNoStdInc[] = "-nostdinc";
         Opts.MetaString = ".";
       }
     }
+    if (Arg* PreambleArg = Args.getLastArg(OPT__preamble_cache_EQ))
+      Opts.PreambleCachePath = PreambleArg->getValue();
+    Opts.AutoloadIndexes = Args.getAllArgValues(OPT__autoload_index_EQ);
 #ifndef NDEBUG
     if (Arg* DebugFlagsArg = Args.getLastArg(OPT__debugFlags, OPT__debugFlags_EQ)) {
       const char *FlagsStr = DebugFlagsArg->getValue();
@@ -214,7 +218,7 @@ bool CompilerOptions::DefaultLanguage(const LangOptions* LangOpts) const {
 
 InvocationOptions::InvocationOptions(int argc, const char* const* argv) :
   MetaString("."), ErrorOut(false), NoLogo(false), ShowVersion(false),
-  Help(false), NoRuntime(false) {
+  Help(false), NoRuntime(false), PtrCheck(false), RuntimePCH(true) {
 
   ArrayRef<const char *> ArgStrings(argv, argv + argc);
   unsigned MissingArgIndex, MissingArgCount;
@@ -456,8 +456,52 @@ namespace cling {
     return false;
   }
 
+  bool LookupHelper::findCachedQuery(llvm::StringRef Key,
+                                     QueryCacheEntry& Entry) const {
+    Interpreter::QueryLockRAII Lock(*m_Interpreter, /*Exclusive=*/false);
+    if (m_QueryCacheGeneration != m_Interpreter->getStateGeneration())
+      return false;
+    auto I = m_QueryCache.find(Key);
+    if (I == m_QueryCache.end())
+      return false;
+    Entry = I->second;
+    return true;
+  }
+
+  void LookupHelper::cacheQuery(llvm::StringRef Key, const void* Result,
+                                const clang::Type* Type) const {
+    // Called with the exclusive lock held; the generation includes whatever
+    // the query itself has committed.
+    unsigned long long Generation = m_Interpreter->getStateGeneration();
+    if (Generation != m_QueryCacheGeneration) {
+      m_QueryCache.clear();
+      m_QueryCacheGeneration = Generation;
+    }
+    m_QueryCache[Key] = {Result, Type};
+  }
+
   QualType LookupHelper::findType(llvm::StringRef typeName,
                                   DiagSetting diagOnOff) const {
+    if (!m_Interpreter->isConcurrentQueriesEnabled())
+      return findTypeImpl(typeName, diagOnOff);
+
+    std::string Key = "T" + typeName.str();
+    QueryCacheEntry Entry;
+    if (findCachedQuery(Key, Entry))
+      return QualType::getFromOpaquePtr(Entry.Result);
+
+    Interpreter::QueryLockRAII Lock(*m_Interpreter, /*Exclusive=*/true);
+    // Another thread might have computed it while we waited for the lock.
+    if (findCachedQuery(Key, Entry))
+      return QualType::getFromOpaquePtr(Entry.Result);
+    QualType Result = findTypeImpl(typeName, diagOnOff);
+    if (!Result.isNull())
+      cacheQuery(Key, Result.getAsOpaquePtr(), nullptr);
+    return Result;
+  }
+
+  QualType LookupHelper::findTypeImpl(llvm::StringRef typeName,
+                                      DiagSetting diagOnOff) const {
     //
     //  Our return value.
     //
@@ -512,6 +556,35 @@ namespace cling {
                                       DiagSetting diagOnOff,
                                       const Type** resultType /* = nullptr */,
                                       bool instantiateTemplate/*=true*/) const {
+    if (!m_Interpreter->isConcurrentQueriesEnabled())
+      return findScopeImpl(className, diagOnOff, resultType,
+                           instantiateTemplate);
+
+    std::string Key = (instantiateTemplate ? "S" : "s") + className.str();
+    QueryCacheEntry Entry;
+    if (!findCachedQuery(Key, Entry)) {
+      Interpreter::QueryLockRAII Lock(*m_Interpreter, /*Exclusive=*/true);
+      // Another thread might have computed it while we waited for the lock.
+      if (!findCachedQuery(Key, Entry)) {
+        const Type* TheType = nullptr;
+        const Decl* Result = findScopeImpl(className, diagOnOff, &TheType,
+                                           instantiateTemplate);
+        if (resultType)
+          *resultType = TheType;
+        if (Result)
+          cacheQuery(Key, Result, TheType);
+        return Result;
+      }
+    }
+    if (resultType)
+      *resultType = Entry.Type;
+    return static_cast<const Decl*>(Entry.Result);
+  }
+
+  const Decl* LookupHelper::findScopeImpl(llvm::StringRef className,
+                                          DiagSetting diagOnOff,
+                                          const Type** resultType,
+                                          bool instantiateTemplate) const {
 
     //
     //  Some utilities.
@@ -791,6 +864,8 @@ namespace cling {
 
     if (Name.empty()) return 0;
 
+    Interpreter::QueryLockRAII Lock(*m_Interpreter, /*Exclusive=*/true);
+
     // Humm ... this seems to do the trick ... or does it? or is there a better way?
 
     // Use P for shortness
@@ -903,6 +978,8 @@ namespace cling {
                                                 DiagSetting diagOnOff) const {
     // Lookup a data member based on its Decl(Context), name.
 
+    Interpreter::QueryLockRAII Lock(*m_Interpreter, /*Exclusive=*/true);
+
     Parser& P = *m_Parser;
     Sema& S = P.getActions();
     Preprocessor& PP = S.getPreprocessor();
@@ -1558,6 +1635,7 @@ namespace cling {
   {
 
     assert(scopeDecl && "Decl cannot be null");
+    Interpreter::QueryLockRAII Lock(*Interp, /*Exclusive=*/true);
     //
     //  Some utilities.
     //
@@ -2011,6 +2089,8 @@ namespace cling {
                                  DiagSetting diagOnOff) const {
     if (argList.empty()) return;
 
+    Interpreter::QueryLockRAII Lock(*m_Interpreter, /*Exclusive=*/true);
+
     //
     //  Some utilities.
     //
@@ -2087,6 +2167,7 @@ namespace cling {
   LookupHelper::StringType
   LookupHelper::getStringType(const clang::Type* Type) {
     assert(Type && "Type cannot be null");
+    Interpreter::QueryLockRAII Lock(*m_Interpreter, /*Exclusive=*/true);
     const Transaction*& Cache = m_Interpreter->getStdStringTransaction();
     if (!Cache || !m_StringTy[kStdString]) {
       // getStringType can be called multiple times with Cache being null, and
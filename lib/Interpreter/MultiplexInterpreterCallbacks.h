@@ -116,6 +116,12 @@ namespace cling {
         }
      }
 
+     void TransactionMemoryAccounted(const Transaction& T) override {
+       for (auto&& cb : m_Callbacks) {
+         cb->TransactionMemoryAccounted(T);
+       }
+     }
+
      void DefinitionShadowed(const clang::NamedDecl* D) override {
        for (auto&& cb : m_Callbacks) {
          cb->DefinitionShadowed(D);
@@ -15,8 +15,8 @@
 
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
 #include "clang/AST/Expr.h"
-#include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/CompilerInstance.h"
@@ -26,10 +26,10 @@
 
 using namespace clang;
 
-namespace {
-using namespace cling;
+namespace cling {
 
-class PointerCheckInjector : public RecursiveASTVisitor<PointerCheckInjector> {
+///\brief Wraps the pointers that get dereferenced in calls checking them.
+class PointerCheckInjector {
   private:
     Interpreter& m_Interp;
     Sema& m_Sema;
@@ -62,9 +62,34 @@ class PointerCheckInjector : public RecursiveASTVisitor<PointerCheckInjector> {
       delete m_clingthrowIfInvalidPointerCache;
     }
 
+    ///\brief Whether the body of FD can get checks: not for constant
+    /// expressions, nor for function templates (we will do the transformation
+    /// on the instance).
+    static bool shouldVisit(FunctionDecl* FD) {
+      switch (FD->getKind()) {
+      case Decl::Function:
+        return !FD->isConstexpr() && !FD->getDescribedFunctionTemplate();
+      case Decl::CXXMethod:
+        return !FD->isConstexpr();
+      default:
+        return true;
+      }
+    }
+
+    ///\brief Adds the checks needed by S; called before S's children are
+    /// visited, which then include the synthesized checks.
+    void visit(Stmt* S) {
+      if (UnaryOperator* UnOp = dyn_cast<UnaryOperator>(S))
+        VisitUnaryOperator(UnOp);
+      else if (MemberExpr* ME = dyn_cast<MemberExpr>(S))
+        VisitMemberExpr(ME);
+      else if (CallExpr* CE = dyn_cast<CallExpr>(S))
+        VisitCallExpr(CE);
+    }
+
+  private:
     bool VisitUnaryOperator(UnaryOperator* UnOp) {
       Expr* SubExpr = UnOp->getSubExpr();
-      VisitStmt(SubExpr);
       if (UnOp->getOpcode() == UO_Deref
           && !IsTransparentThis(SubExpr)
           && SubExpr->getType().getTypePtr()->isPointerType())
@@ -74,7 +99,6 @@ class PointerCheckInjector : public RecursiveASTVisitor<PointerCheckInjector> {
 
     bool VisitMemberExpr(MemberExpr* ME) {
       Expr* Base = ME->getBase();
-      VisitStmt(Base);
       if (ME->isArrow()
           && !IsTransparentThis(Base)
           && ME->getMemberDecl()->isCXXInstanceMember())
@@ -83,7 +107,6 @@ class PointerCheckInjector : public RecursiveASTVisitor<PointerCheckInjector> {
     }
 
     bool VisitCallExpr(CallExpr* CE) {
-      VisitStmt(CE->getCallee());
       FunctionDecl* FDecl = CE->getDirectCallee();
       if (FDecl && isDeclCandidate(FDecl)) {
         decl_map_t::const_iterator it = m_NonNullArgIndexs.find(FDecl);
@@ -102,23 +125,6 @@ class PointerCheckInjector : public RecursiveASTVisitor<PointerCheckInjector> {
       return true;
     }
 
-    bool TraverseFunctionDecl(FunctionDecl* FD) {
-      // We cannot synthesize when there is a const expr
-      // and if it is a function template (we will do the transformation on
-      // the instance).
-      if (!FD->isConstexpr() && !FD->getDescribedFunctionTemplate())
-         RecursiveASTVisitor::TraverseFunctionDecl(FD);
-      return true;
-    }
-
-    bool TraverseCXXMethodDecl(CXXMethodDecl* CXXMD) {
-      // We cannot synthesize when there is a const expr.
-      if (!CXXMD->isConstexpr())
-        RecursiveASTVisitor::TraverseCXXMethodDecl(CXXMD);
-      return true;
-    }
-
-  private:
     Expr* SynthesizeCheck(Expr* Arg) {
       assert(Arg && "Cannot call with Arg=0");
 
@@ -225,6 +231,10 @@ class PointerCheckInjector : public RecursiveASTVisitor<PointerCheckInjector> {
               "Lookup of cling_runtime_internal_throwIfInvalidPointer failed!");
     }
   };
+} // end namespace cling
+
+namespace {
+using namespace cling;
 
   static bool hasPtrCheckDisabledInContext(Sema *S, const Decl* D) {
     if (isa<TranslationUnitDecl>(D))
@@ -305,12 +315,29 @@ namespace cling {
   }
 
 
+  bool NullDerefProtectionTransformer::isEnabled(
+                                        const CompilationOptions& CO) const {
+    return CO.CheckPointerValidity;
+  }
+
+  bool NullDerefProtectionTransformer::beginWalk(clang::Decl* D) {
+    if (!getCompilationOpts().CheckPointerValidity || !shouldTransform(D))
+      return false;
+    m_Injector.reset(new PointerCheckInjector(*m_Interp));
+    return true;
+  }
+
+  bool NullDerefProtectionTransformer::enterFunction(clang::FunctionDecl* FD) {
+    return PointerCheckInjector::shouldVisit(FD);
+  }
+
+  void NullDerefProtectionTransformer::visitStmt(clang::Stmt* S) {
+    m_Injector->visit(S);
+  }
+
   ASTTransformer::Result
-  NullDerefProtectionTransformer::Transform(clang::Decl* D) {
-    if (getCompilationOpts().CheckPointerValidity && shouldTransform(D)) {
-      PointerCheckInjector injector(*m_Interp);
-      injector.TraverseDecl(D);
-    }
+  NullDerefProtectionTransformer::endWalk(clang::Decl* D) {
+    m_Injector.reset();
     return Result(D, true);
   }
 } // end namespace cling
@@ -15,12 +15,15 @@
 
 #include "llvm/ADT/DenseMap.h"
 
+#include <memory>
+
 namespace clang {
   class Decl;
   class DirectoryEntry;
 }
 namespace cling {
   class Interpreter;
+  class PointerCheckInjector;
 }
 
 namespace cling {
@@ -34,6 +37,9 @@ namespace cling {
     /// Whether the declaration should be visited and possibly transformed.
     bool shouldTransform(const clang::Decl* D);
 
+    /// Adds the checks to the declaration being walked.
+    std::unique_ptr<PointerCheckInjector> m_Injector;
+
   public:
     ///\ brief Constructs the NullDeref AST Transformer.
     ///
@@ -42,7 +48,16 @@ namespace cling {
     NullDerefProtectionTransformer(cling::Interpreter* I);
 
     virtual ~NullDerefProtectionTransformer();
-    Result Transform(clang::Decl* D) override;
+
+    const char* getName() const override {
+      return "NullDerefProtectionTransformer";
+    }
+    bool isEnabled(const CompilationOptions& CO) const override;
+    bool usesSharedWalk() const override { return true; }
+    bool beginWalk(clang::Decl* D) override;
+    bool enterFunction(clang::FunctionDecl* FD) override;
+    void visitStmt(clang::Stmt* S) override;
+    Result endWalk(clang::Decl* D) override;
   };
 
 } // namespace cling
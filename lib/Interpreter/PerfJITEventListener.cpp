@@ -7,25 +7,40 @@
 // LICENSE.TXT for details.
 //------------------------------------------------------------------------------
 //
-// This file implements a JITEventListener object that tells perf about JITted
-// symbols using perf map files (/tmp/perf-%d.map, where %d = pid of process).
+// This file implements a JITEventListener object and a JITLink plugin that
+// tell perf about JITted symbols, both through perf map files
+// (/tmp/perf-%d.map, where %d = pid of process) and through jitdump files
+// (jit-%d.dump in $JITDUMPDIR, /tmp by default) that `perf inject --jit`
+// turns into ELF images with the code and its source lines.
 //
-// Documentation for this perf jit interface is available at:
+// Documentation for these perf jit interfaces is available at:
 // https://git.kernel.org/cgit/linux/kernel/git/torvalds/linux.git/tree/tools/perf/Documentation/jit-interface.txt
+// https://git.kernel.org/cgit/linux/kernel/git/torvalds/linux.git/tree/tools/perf/Documentation/jitdump-specification.txt
 //
 //------------------------------------------------------------------------------
 
 #ifdef __linux__
 
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/ExecutionEngine/JITEventListener.h"
+#include "llvm/ExecutionEngine/JITLink/JITLink.h"
+#include "llvm/ExecutionEngine/Orc/Debugging/DebugInfoSupport.h"
+#include "llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Object/SymbolSize.h"
 #include "llvm/Support/ManagedStatic.h"
 
+#include <cinttypes>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <ctime>
 #include <mutex>
+#include <string>
+#include <vector>
 
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 using namespace llvm;
@@ -33,42 +48,242 @@ using namespace llvm::object;
 
 namespace {
 
-  class PerfJITEventListener : public JITEventListener {
-  public:
-    PerfJITEventListener();
-    ~PerfJITEventListener() {
-      if (m_Perfmap)
-        fclose(m_Perfmap);
+  /// Layout of the jitdump file, see jitdump-specification.txt.
+  namespace jitdump {
+    enum : uint32_t {
+      Magic = 0x4A695444, // "JiTD"
+      Version = 1,
+      CodeLoad = 0,
+      DebugInfo = 2,
+      CodeClose = 3
+    };
+
+    struct FileHeader {
+      uint32_t Magic;
+      uint32_t Version;
+      uint32_t TotalSize;
+      uint32_t ElfMach;
+      uint32_t Pad1;
+      uint32_t Pid;
+      uint64_t Timestamp;
+      uint64_t Flags;
+    };
+
+    struct RecordHeader {
+      uint32_t Id;
+      uint32_t TotalSize;
+      uint64_t Timestamp;
+    };
+
+    struct CodeLoadRecord {
+      RecordHeader Prefix;
+      uint32_t Pid;
+      uint32_t Tid;
+      uint64_t Vma;
+      uint64_t CodeAddr;
+      uint64_t CodeSize;
+      uint64_t CodeIndex;
+      // Followed by the null-terminated name and the code bytes.
+    };
+
+    struct DebugInfoRecord {
+      RecordHeader Prefix;
+      uint64_t CodeAddr;
+      uint64_t NrEntry;
+      // Followed by NrEntry DebugEntry, each with a null-terminated file name.
+    };
+
+    struct DebugEntry {
+      uint64_t Addr;
+      uint32_t Line;
+      uint32_t Discrim;
+    };
+
+    static uint32_t getElfMachine() {
+#if defined(__x86_64__)
+      return 62; // EM_X86_64
+#elif defined(__aarch64__)
+      return 183; // EM_AARCH64
+#elif defined(__powerpc64__)
+      return 21; // EM_PPC64
+#elif defined(__i386__)
+      return 3; // EM_386
+#else
+      return 0; // EM_NONE
+#endif
     }
 
-    void notifyObjectLoaded(ObjectKey K, const ObjectFile& Obj,
-                            const RuntimeDyld::LoadedObjectInfo& L) override;
-    void notifyFreeingObject(ObjectKey K) override;
+    /// perf samples are timestamped with the monotonic clock (perf record -k 1).
+    static uint64_t getTimestamp() {
+      timespec TS;
+      clock_gettime(CLOCK_MONOTONIC, &TS);
+      return uint64_t(TS.tv_sec) * 1000000000 + TS.tv_nsec;
+    }
+  } // namespace jitdump
+
+  struct SourceLine {
+    uint64_t Addr;
+    uint32_t Line;
+    std::string File;
+  };
+
+  ///\brief Source lines of [Addr, Addr + Size) from the DWARF in Ctx.
+  static std::vector<SourceLine> getSourceLines(DIContext& Ctx,
+                                                SectionedAddress Addr,
+                                                uint64_t Size) {
+    std::vector<SourceLine> Lines;
+    DILineInfoSpecifier Spec(
+        DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+        DILineInfoSpecifier::FunctionNameKind::None);
+    for (auto&& L : Ctx.getLineInfoForAddressRange(Addr, Size, Spec))
+      Lines.push_back({L.first, L.second.Line, L.second.FileName});
+    return Lines;
+  }
+
+  ///\brief The perf map and jitdump files of this process, shared by the
+  /// RuntimeDyld listener and the JITLink plugin.
+  class PerfOutput {
+  public:
+    PerfOutput();
+    ~PerfOutput();
+
+    void addFunction(StringRef Name, uint64_t Addr, uint64_t Size,
+                     const char* Code, const std::vector<SourceLine>& Lines);
 
   private:
+    void writeDebugInfo(uint64_t Addr, const std::vector<SourceLine>& Lines);
+
     std::mutex m_Mutex;
-    FILE* m_Perfmap;
+    FILE* m_Perfmap = nullptr;
+    FILE* m_Dump = nullptr;
+    void* m_Marker = nullptr;
+    size_t m_MarkerSize = 0;
+    uint64_t m_CodeIndex = 0;
+    uint32_t m_Pid;
   };
 
-  PerfJITEventListener::PerfJITEventListener() {
+  PerfOutput::PerfOutput() : m_Pid(getpid()) {
     char filename[64];
-    snprintf(filename, 64, "/tmp/perf-%d.map", getpid());
+    snprintf(filename, 64, "/tmp/perf-%d.map", m_Pid);
     m_Perfmap = fopen(filename, "a");
+
+    std::string DumpPath = "/tmp";
+    if (const char* Dir = std::getenv("JITDUMPDIR"))
+      DumpPath = Dir;
+    DumpPath += "/jit-" + std::to_string(m_Pid) + ".dump";
+    // Truncate: a dump left by an earlier process with the same pid is stale.
+    m_Dump = fopen(DumpPath.c_str(), "w+");
+    if (!m_Dump)
+      return;
+
+    // perf finds the dump through the executable mapping of it recorded in
+    // the perf.data; the mapping itself is never accessed.
+    m_MarkerSize = sysconf(_SC_PAGESIZE);
+    m_Marker = mmap(nullptr, m_MarkerSize, PROT_READ | PROT_EXEC, MAP_PRIVATE,
+                    fileno(m_Dump), 0);
+    if (m_Marker == MAP_FAILED)
+      m_Marker = nullptr;
+
+    jitdump::FileHeader Header = {jitdump::Magic,
+                                  jitdump::Version,
+                                  sizeof(jitdump::FileHeader),
+                                  jitdump::getElfMachine(),
+                                  0,
+                                  m_Pid,
+                                  jitdump::getTimestamp(),
+                                  0};
+    fwrite(&Header, sizeof(Header), 1, m_Dump);
+    fflush(m_Dump);
+  }
+
+  PerfOutput::~PerfOutput() {
+    if (m_Perfmap)
+      fclose(m_Perfmap);
+    if (m_Dump) {
+      jitdump::RecordHeader Close = {jitdump::CodeClose,
+                                     sizeof(jitdump::RecordHeader),
+                                     jitdump::getTimestamp()};
+      fwrite(&Close, sizeof(Close), 1, m_Dump);
+      if (m_Marker)
+        munmap(m_Marker, m_MarkerSize);
+      fclose(m_Dump);
+    }
+  }
+
+  void PerfOutput::writeDebugInfo(uint64_t Addr,
+                                  const std::vector<SourceLine>& Lines) {
+    size_t Size = sizeof(jitdump::DebugInfoRecord);
+    for (const SourceLine& L : Lines)
+      Size += sizeof(jitdump::DebugEntry) + L.File.size() + 1;
+
+    jitdump::DebugInfoRecord Rec = {
+        {jitdump::DebugInfo, uint32_t(Size), jitdump::getTimestamp()},
+        Addr,
+        Lines.size()};
+    fwrite(&Rec, sizeof(Rec), 1, m_Dump);
+    for (const SourceLine& L : Lines) {
+      jitdump::DebugEntry Entry = {L.Addr, L.Line, 0};
+      fwrite(&Entry, sizeof(Entry), 1, m_Dump);
+      fwrite(L.File.c_str(), L.File.size() + 1, 1, m_Dump);
+    }
+  }
+
+  void PerfOutput::addFunction(StringRef Name, uint64_t Addr, uint64_t Size,
+                               const char* Code,
+                               const std::vector<SourceLine>& Lines) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_Perfmap) {
+      fprintf(m_Perfmap, "%" PRIx64 " %" PRIx64 " %.*s\n", Addr, Size,
+              int(Name.size()), Name.data());
+      fflush(m_Perfmap);
+    }
+
+    if (!m_Dump)
+      return;
+
+    // The debug info has to precede the code load it describes.
+    if (!Lines.empty())
+      writeDebugInfo(Addr, Lines);
+
+    // Every load gets a new index, so perf tells code apart that was JITted
+    // at an address freed by an earlier unload.
+    jitdump::CodeLoadRecord Rec = {
+        {jitdump::CodeLoad,
+         uint32_t(sizeof(jitdump::CodeLoadRecord) + Name.size() + 1 + Size),
+         jitdump::getTimestamp()},
+        m_Pid,
+        uint32_t(syscall(SYS_gettid)),
+        Addr,
+        Addr,
+        Size,
+        m_CodeIndex++};
+    fwrite(&Rec, sizeof(Rec), 1, m_Dump);
+    fwrite(Name.data(), Name.size(), 1, m_Dump);
+    fputc('\0', m_Dump);
+    fwrite(Code, Size, 1, m_Dump);
+    fflush(m_Dump);
   }
 
+  llvm::ManagedStatic<PerfOutput> PerfOut;
+
+  class PerfJITEventListener : public JITEventListener {
+  public:
+    void notifyObjectLoaded(ObjectKey K, const ObjectFile& Obj,
+                            const RuntimeDyld::LoadedObjectInfo& L) override;
+    void notifyFreeingObject(ObjectKey K) override;
+  };
+
   void PerfJITEventListener::notifyObjectLoaded(
       ObjectKey K, const ObjectFile& Obj,
       const RuntimeDyld::LoadedObjectInfo& L) {
 
-    if (!m_Perfmap)
-      return;
-
     OwningBinary<ObjectFile> DebugObjOwner = L.getObjectForDebug(Obj);
     const ObjectFile& DebugObj = *DebugObjOwner.getBinary();
+    std::unique_ptr<DIContext> Context = DWARFContext::create(DebugObj);
 
     // For each symbol, we want to check its address and size
     // if it's a function and write the information to the perf
-    // map file, otherwise we just ignore the symbol and any
+    // map and jitdump files, otherwise we just ignore the symbol and any
     // related errors. This implementation is adapted from LLVM:
     // llvm/src/lib/ExecutionEngine/PerfJITEvents/PerfJITEventListener.cpp
 
@@ -104,26 +319,88 @@ namespace {
       if (size == 0)
         continue;
 
-      std::lock_guard<std::mutex> lock(m_Mutex);
-      fprintf(m_Perfmap, "%" PRIx64 " %" PRIx64 " %s\n", address, size,
-              Name->data());
-    }
+      SectionedAddress SecAddr = {address, SectionedAddress::UndefSection};
+      if (Expected<section_iterator> SecOrErr = Sym.getSection()) {
+        if (*SecOrErr != DebugObj.section_end())
+          SecAddr.SectionIndex = (*SecOrErr)->getIndex();
+      } else
+        consumeError(SecOrErr.takeError());
 
-    fflush(m_Perfmap);
+      // The debug object has its sections moved to their load addresses;
+      // the code is readable there, in this process.
+      PerfOut->addFunction(*Name, address, size,
+                           reinterpret_cast<const char*>(address),
+                           getSourceLines(*Context, SecAddr, size));
+    }
   }
 
   void PerfJITEventListener::notifyFreeingObject(ObjectKey K) {
-    // nothing to be done
+    // jitdump has no unload record: perf orders the code loads by timestamp,
+    // so a later load at a reused address supersedes the freed code.
   }
 
   llvm::ManagedStatic<PerfJITEventListener> PerfListener;
 
+  ///\brief Reports the functions of each JITLink graph once its fixups are
+  /// applied, with the source lines from its (preserved) debug sections.
+  class PerfJITLinkPlugin : public orc::ObjectLinkingLayer::Plugin {
+  public:
+    void modifyPassConfig(orc::MaterializationResponsibility& MR,
+                          jitlink::LinkGraph& G,
+                          jitlink::PassConfiguration& Config) override {
+      Config.PrePrunePasses.push_back(orc::preserveDebugSections);
+      Config.PostFixupPasses.push_back(registerFunctions);
+    }
+
+    Error notifyFailed(orc::MaterializationResponsibility& MR) override {
+      return Error::success();
+    }
+
+    Error notifyRemovingResources(orc::JITDylib& JD,
+                                  orc::ResourceKey K) override {
+      // As with notifyFreeingObject: superseded by later loads.
+      return Error::success();
+    }
+
+    void notifyTransferringResources(orc::JITDylib& JD, orc::ResourceKey DstKey,
+                                     orc::ResourceKey SrcKey) override {}
+
+  private:
+    static Error registerFunctions(jitlink::LinkGraph& G) {
+      auto DWARFOrErr = orc::createDWARFContext(G);
+      if (!DWARFOrErr)
+        consumeError(DWARFOrErr.takeError());
+
+      for (jitlink::Symbol* Sym : G.defined_symbols()) {
+        if (!Sym->hasName() || !Sym->isCallable() || !Sym->getSize() ||
+            Sym->getBlock().isZeroFill())
+          continue;
+
+        uint64_t Addr = Sym->getAddress().getValue();
+        std::vector<SourceLine> Lines;
+        if (DWARFOrErr)
+          Lines = getSourceLines(*DWARFOrErr->first,
+                                 {Addr, SectionedAddress::UndefSection},
+                                 Sym->getSize());
+        PerfOut->addFunction(Sym->getName(), Addr, Sym->getSize(),
+                             Sym->getBlock().getContent().data() +
+                                 Sym->getOffset(),
+                             Lines);
+      }
+      return Error::success();
+    }
+  };
+
 } // end anonymous namespace
 
 namespace cling {
 
   JITEventListener* createPerfJITEventListener() { return &*PerfListener; }
 
+  std::unique_ptr<orc::ObjectLinkingLayer::Plugin> createPerfJITLinkPlugin() {
+    return std::make_unique<PerfJITLinkPlugin>();
+  }
+
 } // namespace cling
 
 #endif
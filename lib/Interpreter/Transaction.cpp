@@ -46,6 +46,7 @@ namespace cling {
     m_Module = 0;
     m_WrapperFD = 0;
     m_Next = 0;
+    m_Serial = 0;
     m_BufferFID = FileID(); // sets it to invalid.
     m_Exe = 0;
   }
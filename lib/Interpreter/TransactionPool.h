@@ -14,6 +14,8 @@
 
 #include "llvm/ADT/SmallVector.h"
 
+#include <algorithm>
+
 namespace clang {
   class Sema;
 }
@@ -26,7 +28,10 @@ namespace cling {
 #else
       kDebugMode           = 1, // Always use a new Transaction
 #endif
-      kPoolSize            = 16
+      kPoolSize            = 16,
+      // Transactions in flight per nesting level: the transaction itself and
+      // the ones for deserialization, instantiation and codegen.
+      kTransactionsPerLevel = 4
     };
 
     // It is twice the size of the block because there might be easily around 8
@@ -36,6 +41,11 @@ namespace cling {
     //
     llvm::SmallVector<Transaction*, kPoolSize>  m_Transactions;
 
+    ///\brief Number of transactions kept for reuse; grows with the deepest
+    /// nesting of released transactions.
+    ///
+    size_t m_Capacity = kPoolSize;
+
   public:
     TransactionPool() {}
     ~TransactionPool() {
@@ -70,11 +80,17 @@ namespace cling {
       }
 
       // Tell the parent that T is gone.
-      if (T->getParent())
+      if (Transaction* Parent = T->getParent()) {
+        size_t Depth = 1;
+        for (; Parent->getParent(); Parent = Parent->getParent())
+          ++Depth;
+        m_Capacity = std::max<size_t>(m_Capacity,
+                                      (Depth + 1) * kTransactionsPerLevel);
         T->getParent()->removeNestedTransaction(T);
+      }
 
       // don't overflow the pool
-      if (reuse && (m_Transactions.size() < kPoolSize)) {
+      if (reuse && (m_Transactions.size() < m_Capacity)) {
         T->m_State = Transaction::kNumStates;
         T->~Transaction();
         m_Transactions.push_back(T);
@@ -14,6 +14,7 @@
 
 #include "cling/Interpreter/Interpreter.h"
 #include "cling/Interpreter/Transaction.h"
+#include "cling/Utils/AST.h"
 
 #include "clang/AST/Decl.h"
 #include "clang/AST/DependentDiagnostic.h"
@@ -112,10 +113,48 @@ namespace cling {
   }
 #endif
 
+  TransactionUnloader::~TransactionUnloader() {}
+
+  void TransactionUnloader::beginBatch(llvm::ArrayRef<Transaction*> Ts) {
+    assert(m_Batch.empty() && "Batch already started");
+    m_Batch.insert(Ts.begin(), Ts.end());
+    m_BatchDeclU.reset(new DeclUnloader(m_Sema, m_CodeGen, nullptr));
+    m_BatchJITSuccessful = true;
+
+    if (!getExecutor())
+      return;
+
+    for (Transaction* T : Ts) {
+      if (T->getState() != Transaction::kCommitted || T->isNestedTransaction())
+        continue;
+      if (const llvm::Module *CompiledM = T->getCompiledModule())
+        unloadModule(const_cast<llvm::Module*>(CompiledM));
+      else
+        assert((!T->getModule() || isPracticallyEmptyModule(T->getModule()))
+               && "Must have already compiled this module");
+    }
+
+    // All resource trackers are merged and removed at once.
+    if (llvm::Error Err = getExecutor()->unloadModules(Ts)) {
+      llvm::logAllUnhandledErrors(std::move(Err), llvm::errs(), "Unload: ");
+      m_BatchJITSuccessful = false;
+    }
+  }
+
+  void TransactionUnloader::endBatch() {
+    // Destroying the DeclUnloader invalidates the files it collected.
+    m_BatchDeclU.reset();
+    m_Batch.clear();
+    utils::TypeName::InvalidateCache(m_Sema->getASTContext());
+  }
+
   bool TransactionUnloader::RevertTransaction(Transaction* T) {
 
     bool Successful = true;
-    if (getExecutor()) {
+    const bool Batched = isInBatch(T);
+    if (Batched)
+      Successful = m_BatchJITSuccessful;
+    else if (getExecutor()) {
       if (T->getState() == Transaction::kCommitted && !T->isNestedTransaction()) {
         if (const llvm::Module *CompiledM = T->getCompiledModule())
           Successful = unloadModule(const_cast<llvm::Module*>(CompiledM)) &&
@@ -143,10 +182,22 @@ namespace cling {
     m_Sema->PendingInstantiations.clear();
     m_Sema->PendingLocalImplicitInstantiations.clear();
 
-    DeclUnloader DeclU(m_Sema, m_CodeGen, T);
-    Successful = unloadDeclarations(T, DeclU) && Successful;
-    Successful = unloadDeserializedDeclarations(T, DeclU) && Successful;
-    Successful = unloadFromPreprocessor(T, DeclU) && Successful;
+    if (Batched) {
+      // Nested transactions come back here through Interpreter::unload()
+      // while their parent is still being reverted.
+      DeclUnloader& DeclU = *m_BatchDeclU;
+      const Transaction* PrevT = DeclU.getCurrentTransaction();
+      DeclU.setCurrentTransaction(T);
+      Successful = unloadDeclarations(T, DeclU) && Successful;
+      Successful = unloadDeserializedDeclarations(T, DeclU) && Successful;
+      Successful = unloadFromPreprocessor(T, DeclU) && Successful;
+      DeclU.setCurrentTransaction(PrevT);
+    } else {
+      DeclUnloader DeclU(m_Sema, m_CodeGen, T);
+      Successful = unloadDeclarations(T, DeclU) && Successful;
+      Successful = unloadDeserializedDeclarations(T, DeclU) && Successful;
+      Successful = unloadFromPreprocessor(T, DeclU) && Successful;
+    }
 
 #ifndef NDEBUG
     //FIXME: Move the nested transaction marker out of the decl lists and
@@ -156,6 +207,11 @@ namespace cling {
     //  assert (!DeclSize && "No parsed decls must happen in parse for module");
 #endif
 
+    // Memoized type names might refer to what was just unloaded; a batch
+    // drops them once in endBatch().
+    if (!Batched)
+      utils::TypeName::InvalidateCache(m_Sema->getASTContext());
+
     if (Successful)
       T->setState(Transaction::kRolledBack);
     else
@@ -10,6 +10,9 @@
 #ifndef CLING_TRANSACTION_UNLOADER
 #define CLING_TRANSACTION_UNLOADER
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallPtrSet.h"
+
 #include <memory>
 
 namespace llvm {
@@ -38,6 +41,19 @@ namespace cling {
     clang::CodeGenerator* m_CodeGen;
     cling::IncrementalExecutor* m_Exe;
 
+    ///\brief The transactions prepared by beginBatch().
+    ///
+    llvm::SmallPtrSet<const Transaction*, 32> m_Batch;
+
+    ///\brief The DeclUnloader shared by all transactions of the batch, so that
+    /// the files to uncache are collected and invalidated only once.
+    ///
+    std::unique_ptr<DeclUnloader> m_BatchDeclU;
+
+    ///\brief Whether the JIT removal of the batch succeeded.
+    ///
+    bool m_BatchJITSuccessful = true;
+
     bool unloadDeclarations(Transaction* T, DeclUnloader& DeclU);
     bool unloadDeserializedDeclarations(Transaction* T,
                                         DeclUnloader& DeclU);
@@ -49,6 +65,26 @@ namespace cling {
                         clang::CodeGenerator* CG,
                         cling::IncrementalExecutor* Exe):
       m_Interp(I), m_Sema(Sema), m_CodeGen(CG), m_Exe(Exe) {}
+    ~TransactionUnloader();
+
+    ///\brief Starts unloading several transactions at once.
+    ///
+    /// Removes the generated code of all of them from the JIT in one go; the
+    /// following calls to RevertTransaction() for any of them only revert
+    /// the AST and share a single DeclUnloader.
+    ///
+    ///\param[in] Ts - The transactions to be reverted, including the nested
+    ///                 ones.
+    ///
+    void beginBatch(llvm::ArrayRef<Transaction*> Ts);
+
+    ///\brief Finishes the batch, invalidating the collected file caches.
+    ///
+    void endBatch();
+
+    ///\brief Whether the transaction was passed to beginBatch().
+    ///
+    bool isInBatch(const Transaction* T) const { return m_Batch.count(T); }
 
     ///\brief Rolls back given transaction from the AST.
     ///
@@ -57,6 +57,10 @@ namespace cling {
     };
   }
 
+  bool ValueExtractionSynthesizer::isEnabled(const CompilationOptions& CO) const {
+    return CO.ResultEvaluation || CO.ValuePrinting;
+  }
+
   ASTTransformer::Result ValueExtractionSynthesizer::Transform(clang::Decl* D) {
     const CompilationOptions& CO = getCompilationOpts();
     // If we do not evaluate the result, or printing out the result return.
@@ -201,6 +205,18 @@ namespace {
     }
     return true;
   }
+
+  // Whether the result can refer to the object instead of copying it: the
+  // object must outlive the wrapper, i.e. be a variable with static storage.
+  // It then lives as long as the transaction that declared it.
+  static bool isBorrowable(const Expr* E) {
+    if (E->getValueKind() != VK_LValue)
+      return false;
+    if (const auto* DRE = dyn_cast<DeclRefExpr>(E->IgnoreParens()))
+      if (const auto* VD = dyn_cast<VarDecl>(DRE->getDecl()))
+        return VD->hasGlobalStorage();
+    return false;
+  }
 }
 
   Expr* ValueExtractionSynthesizer::SynthesizeSVRInit(Expr* E) {
@@ -239,6 +255,12 @@ namespace {
       // a reference to the lvalue instead of copying it.
       desugaredTy = m_Context->getLValueReferenceType(desugaredTy);
       ETy = m_Context->getLValueReferenceType(ETy);
+    } else if (desugaredTy->isConstantArrayType()
+               && getCompilationOpts().BorrowResults && isBorrowable(E)) {
+      // Same for arrays if requested: pass the address of the variable
+      // instead of copying all elements.
+      desugaredTy = m_Context->getLValueReferenceType(desugaredTy);
+      ETy = m_Context->getLValueReferenceType(ETy);
     }
     Expr* ETyVP
       = utils::Synthesize::CStyleCastPtrExpr(m_Sema, m_Context->VoidPtrTy,
@@ -59,6 +59,10 @@ public:
     virtual ~ValueExtractionSynthesizer();
 
     Result Transform(clang::Decl* D) override;
+    const char* getName() const override {
+      return "ValueExtractionSynthesizer";
+    }
+    bool isEnabled(const CompilationOptions& CO) const override;
 
   private:
 
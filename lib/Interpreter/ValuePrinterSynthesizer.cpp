@@ -38,6 +38,10 @@ namespace cling {
   ValuePrinterSynthesizer::~ValuePrinterSynthesizer()
   { }
 
+  bool ValuePrinterSynthesizer::isEnabled(const CompilationOptions& CO) const {
+    return CO.ValuePrinting != CompilationOptions::VPDisabled;
+  }
+
   ASTTransformer::Result ValuePrinterSynthesizer::Transform(clang::Decl* D) {
     if (getCompilationOpts().ValuePrinting == CompilationOptions::VPDisabled)
       return Result(D, true);
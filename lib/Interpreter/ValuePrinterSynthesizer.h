@@ -49,6 +49,8 @@ public:
     virtual ~ValuePrinterSynthesizer();
 
     Result Transform(clang::Decl* D) override;
+    const char* getName() const override { return "ValuePrinterSynthesizer"; }
+    bool isEnabled(const CompilationOptions& CO) const override;
 
   private:
     ///\brief Tries to attach a value printing mechanism to the given decl group
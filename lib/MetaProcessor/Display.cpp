@@ -10,6 +10,7 @@
 #include "cling/MetaProcessor/Display.h"
 
 #include "cling/Interpreter/Interpreter.h"
+#include "cling/Interpreter/InterpreterCallbacks.h"
 #include "cling/Interpreter/LookupHelper.h"
 
 #include "clang/AST/ASTContext.h"
@@ -28,16 +29,22 @@
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/Preprocessor.h"
 
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Regex.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <cctype>
+#include <iterator>
 #include <limits>
+#include <map>
+#include <memory>
 #include <set>
+#include <vector>
 
 using namespace clang;
 
@@ -435,6 +442,255 @@ void FILEPrintHelper::Print(const char* msg)const
   fStream.flush();
 }
 
+//
+//Names known to the interpreter, taken from its identifier table and from
+//the identifier tables of the attached PCH/modules. Filtered listings look
+//up only the names they match instead of walking (and thus deserializing)
+//the whole translation unit.
+//
+class NameIndex : public InterpreterCallbacks {
+public:
+  NameIndex(Interpreter* interpreter);
+  ~NameIndex();
+
+  //The index of 'interpreter', created and registered on first use.
+  static NameIndex& Get(const Interpreter* interpreter);
+
+  void TransactionCommitted(const Transaction&) override;
+  void TransactionUnloaded(const Transaction&) override;
+
+  //Sorted and unique.
+  const std::vector<llvm::StringRef>& GetNames();
+
+private:
+  //The strings are owned by the identifier tables, which never drop entries.
+  std::vector<llvm::StringRef> fExternalNames;
+  std::vector<llvm::StringRef> fNames;
+  const IdentifierInfoLookup* fExternalLookup;
+  bool fIsStale;
+};
+
+//______________________________________________________________________________
+static std::map<const Interpreter*, NameIndex*>& GetNameIndexes()
+{
+  //Never destroyed: interpreters, and with them the indexes, can outlive
+  //function-local statics.
+  static auto* indexes = new std::map<const Interpreter*, NameIndex*>();
+  return *indexes;
+}
+
+//______________________________________________________________________________
+NameIndex::NameIndex(Interpreter* interpreter)
+             : InterpreterCallbacks(interpreter),
+               fExternalLookup(nullptr),
+               fIsStale(true)
+{
+}
+
+//______________________________________________________________________________
+NameIndex::~NameIndex()
+{
+  GetNameIndexes().erase(m_Interpreter);
+}
+
+//______________________________________________________________________________
+NameIndex& NameIndex::Get(const Interpreter* interpreter)
+{
+  NameIndex*& index = GetNameIndexes()[interpreter];
+  if (!index) {
+    Interpreter* const owner = const_cast<Interpreter*>(interpreter);
+    auto newIndex = std::make_unique<NameIndex>(owner);
+    index = newIndex.get();
+    //The interpreter owns its callbacks, the index dies with it.
+    owner->setCallbacks(std::move(newIndex));
+  }
+  return *index;
+}
+
+//______________________________________________________________________________
+void NameIndex::TransactionCommitted(const Transaction&)
+{
+  //New input brings new identifiers; pick them up on the next listing.
+  fIsStale = true;
+}
+
+//______________________________________________________________________________
+void NameIndex::TransactionUnloaded(const Transaction&)
+{
+  fIsStale = true;
+}
+
+//______________________________________________________________________________
+const std::vector<llvm::StringRef>& NameIndex::GetNames()
+{
+  const IdentifierTable& idents = m_Interpreter->getCI()->getASTContext().Idents;
+
+  //The external tables only change when PCH/modules are attached.
+  IdentifierInfoLookup* const external = idents.getExternalIdentifierLookup();
+  if (external != fExternalLookup) {
+    fExternalLookup = external;
+    fExternalNames.clear();
+    if (external) {
+      std::unique_ptr<IdentifierIterator> it(external->getIdentifiers());
+      if (it) {
+        for (llvm::StringRef name = it->Next(); !name.empty(); name = it->Next())
+          fExternalNames.push_back(name);
+      }
+    }
+    std::sort(fExternalNames.begin(), fExternalNames.end());
+    fIsStale = true;
+  }
+
+  if (!fIsStale)
+    return fNames;
+
+  std::vector<llvm::StringRef> localNames;
+  localNames.reserve(idents.size());
+  for (const auto& entry : idents)
+    if (entry.getValue()->getTokenID() == tok::identifier)
+      localNames.push_back(entry.getKey());
+  std::sort(localNames.begin(), localNames.end());
+
+  fNames.clear();
+  fNames.reserve(fExternalNames.size() + localNames.size());
+  std::set_union(fExternalNames.begin(), fExternalNames.end(),
+                 localNames.begin(), localNames.end(),
+                 std::back_inserter(fNames));
+  fNames.erase(std::unique(fNames.begin(), fNames.end()), fNames.end());
+  fIsStale = false;
+  return fNames;
+}
+
+//
+//Matches unqualified names against the pattern of a DisplayFilter. Wildcard
+//patterns are turned into a name prefix, used to jump into the sorted index,
+//and a regular expression for the rest.
+//
+class NameMatcher {
+public:
+  NameMatcher(const DisplayFilter& filter);
+
+  bool IsValid(std::string& error)const;
+  llvm::StringRef GetPrefix()const { return fPrefix; }
+  bool Matches(llvm::StringRef name)const;
+
+private:
+  std::string fPrefix;
+  std::unique_ptr<llvm::Regex> fRegex;
+  bool fExact;
+};
+
+//______________________________________________________________________________
+NameMatcher::NameMatcher(const DisplayFilter& filter)
+               : fExact(false)
+{
+  if (filter.IsRegex) {
+    fRegex.reset(new llvm::Regex(filter.Pattern));
+    return;
+  }
+
+  const llvm::StringRef pattern(filter.Pattern);
+  const size_t wildcard = pattern.find_first_of("*?");
+  fPrefix = pattern.substr(0, wildcard).str();
+  if (wildcard == llvm::StringRef::npos) {
+    fExact = true;
+    return;
+  }
+  //A trailing '*' is all the prefix needs.
+  if (wildcard == pattern.size() - 1 && pattern.back() == '*')
+    return;
+
+  std::string regex("^");
+  for (char c : pattern) {
+    if (c == '*')
+      regex += ".*";
+    else if (c == '?')
+      regex += '.';
+    else
+      regex += llvm::Regex::escape(llvm::StringRef(&c, 1));
+  }
+  regex += '$';
+  fRegex.reset(new llvm::Regex(regex));
+}
+
+//______________________________________________________________________________
+bool NameMatcher::IsValid(std::string& error)const
+{
+  return !fRegex || fRegex->isValid(error);
+}
+
+//______________________________________________________________________________
+bool NameMatcher::Matches(llvm::StringRef name)const
+{
+  if (fExact)
+    return name == fPrefix;
+  if (!name.starts_with(fPrefix))
+    return false;
+  return !fRegex || fRegex->match(name);
+}
+
+//______________________________________________________________________________
+//Looks up every indexed name matched by 'filter' in the scope it selects and
+//passes the results to 'entry', which returns whether the name denotes
+//something it lists and prints it if 'print' is set. Only looked up names
+//get their declarations deserialized. Returns the number of entries printed.
+template <typename Entry>
+unsigned DisplayIndexedDecls(const Interpreter* interpreter,
+                             const FILEPrintHelper& out,
+                             const DisplayFilter& filter, Entry entry)
+{
+  assert(interpreter != nullptr && "DisplayIndexedDecls, interpreter is null");
+
+  NameMatcher matcher(filter);
+  std::string error;
+  if (!matcher.IsValid(error)) {
+    out.Print(("Invalid pattern " + filter.Pattern + ": " + error + "\n").c_str());
+    return 0;
+  }
+
+  // Could trigger deserialization of decls.
+  Interpreter::PushTransactionRAII RAII(const_cast<Interpreter*>(interpreter));
+
+  ASTContext& ctx = interpreter->getCI()->getASTContext();
+  const DeclContext* scope = ctx.getTranslationUnitDecl();
+  if (!filter.Scope.empty()) {
+    const cling::LookupHelper& lookupHelper = interpreter->getLookupHelper();
+    const Decl* scopeDecl
+      = lookupHelper.findScope(filter.Scope, cling::LookupHelper::NoDiagnostics);
+    if (const CXXRecordDecl* const classDecl
+          = dyn_cast_or_null<CXXRecordDecl>(scopeDecl))
+      scopeDecl = classDecl->getDefinition();
+    scope = dyn_cast_or_null<DeclContext>(scopeDecl);
+    if (!scope) {
+      out.Print(("Scope " + filter.Scope + " not found\n").c_str());
+      return 0;
+    }
+  }
+
+  const std::vector<llvm::StringRef>& names
+    = NameIndex::Get(interpreter).GetNames();
+  unsigned skipped = 0, printed = 0;
+  for (auto name = std::lower_bound(names.begin(), names.end(),
+                                    matcher.GetPrefix());
+       name != names.end() && name->starts_with(matcher.GetPrefix()); ++name) {
+    if (filter.Count && printed == filter.Count)
+      break;
+    if (!matcher.Matches(*name))
+      continue;
+
+    const IdentifierInfo& identifier = ctx.Idents.get(*name);
+    const DeclContext::lookup_result decls = scope->lookup(&identifier);
+    if (skipped < filter.First) {
+      if (entry(identifier, decls, /*print*/ false))
+        ++skipped;
+      continue;
+    }
+    if (entry(identifier, decls, /*print*/ true))
+      ++printed;
+  }
+  return printed;
+}
+
 //
 //Aux. class to traverse translation-unit-declaration/class-declaration.
 //
@@ -450,6 +706,7 @@ public:
 
   void DisplayAllClasses()const;
   void DisplayClass(const std::string& className)const;
+  void DisplayClasses(const DisplayFilter& filter)const;
 
   void SetVerbose(bool verbose);
 
@@ -555,6 +812,37 @@ void ClassPrinter::DisplayClass(const std::string& className)const
     fOut.Print(("Class " + className + " not found\n").c_str());
 }
 
+//______________________________________________________________________________
+void ClassPrinter::DisplayClasses(const DisplayFilter& filter)const
+{
+  assert(fInterpreter != nullptr && "DisplayClasses, fInterpreter is null");
+
+  fOut.Print("List of classes\n");
+  const unsigned count = DisplayIndexedDecls(fInterpreter, fOut, filter,
+    [this](const IdentifierInfo&, DeclContext::lookup_result decls, bool print) {
+      bool found = false;
+      for (NamedDecl* decl : decls) {
+        if (const CXXRecordDecl* const classDecl = dyn_cast<CXXRecordDecl>(decl)) {
+          found = true;
+          if (!print)
+            continue;
+          if (classDecl->hasDefinition())
+            DisplayClassDecl(classDecl);
+          else
+            DisplayClassFwdDecl(classDecl);
+        } else if (isa<ClassTemplateDecl>(decl)) {
+          found = true;
+          if (print)
+            ProcessClassTemplateDecl(decl_iterator(decl));
+        }
+      }
+      return found;
+    });
+
+  if (!count)
+    fOut.Print(("No class matches " + filter.Pattern + "\n").c_str());
+}
+
 //______________________________________________________________________________
 void ClassPrinter::SetVerbose(bool verbose)
 {
@@ -1086,6 +1374,7 @@ public:
 
   void DisplayGlobals()const;
   void DisplayGlobal(const std::string& name)const;
+  void DisplayGlobals(const DisplayFilter& filter)const;
 
 private:
   template <typename T, typename... Args>
@@ -1206,6 +1495,46 @@ void GlobalsPrinter::DisplayGlobal(const std::string& name)const
     fOut.Print(("Variable " + name + " not found\n").c_str());
 }
 
+//______________________________________________________________________________
+void GlobalsPrinter::DisplayGlobals(const DisplayFilter& filter)const
+{
+  assert(fInterpreter != nullptr && "DisplayGlobals, fInterpreter is null");
+
+  const Preprocessor& pp = fInterpreter->getCI()->getPreprocessor();
+  const bool inGlobalScope = filter.Scope.empty();
+  const unsigned count = DisplayIndexedDecls(fInterpreter, fOut, filter,
+    [&](const IdentifierInfo& identifier, DeclContext::lookup_result decls,
+        bool print) {
+      bool found = false;
+      //Only this macro gets deserialized, not the whole macro table.
+      if (inGlobalScope && identifier.hasMacroDefinition()) {
+        const MacroInfo* const macroInfo = pp.getMacroInfo(&identifier);
+        if (macroInfo && macroInfo->isObjectLike()) {
+          found = true;
+          if (print)
+            DisplayObjectLikeMacro(&identifier, macroInfo);
+        }
+      }
+      for (NamedDecl* decl : decls) {
+        if (const VarDecl* const varDecl = dyn_cast<VarDecl>(decl)) {
+          found = true;
+          if (print)
+            DisplayVarDecl(varDecl);
+        } else if (const EnumConstantDecl* const enumerator
+                     = dyn_cast<EnumConstantDecl>(decl)) {
+          found = true;
+          if (print)
+            DisplayEnumeratorDecl(enumerator);
+        }
+      }
+      return found;
+    });
+
+  //Do as CINT does:
+  if (!count)
+    fOut.Print(("Variable " + filter.Pattern + " not found\n").c_str());
+}
+
 //______________________________________________________________________________
 void GlobalsPrinter::DisplayVarDecl(const VarDecl* varDecl) const
 {
@@ -1386,6 +1715,7 @@ public:
 
   void DisplayTypedefs()const;
   void DisplayTypedef(const std::string& name)const;
+  void DisplayTypedefs(const DisplayFilter& filter)const;
 
 private:
 
@@ -1447,6 +1777,29 @@ void TypedefPrinter::DisplayTypedef(const std::string& typedefName)const
   fOut.Print(("Type " + typedefName + " is not defined\n").c_str());
 }
 
+//______________________________________________________________________________
+void TypedefPrinter::DisplayTypedefs(const DisplayFilter& filter)const
+{
+  assert(fInterpreter != nullptr && "DisplayTypedefs, fInterpreter is null");
+
+  fOut.Print("List of typedefs\n");
+  const unsigned count = DisplayIndexedDecls(fInterpreter, fOut, filter,
+    [this](const IdentifierInfo&, DeclContext::lookup_result decls, bool print) {
+      bool found = false;
+      for (NamedDecl* decl : decls) {
+        if (TypedefNameDecl* const typedefDecl = dyn_cast<TypedefNameDecl>(decl)) {
+          found = true;
+          if (print)
+            DisplayTypedefDecl(typedefDecl);
+        }
+      }
+      return found;
+    });
+
+  if (!count)
+    fOut.Print(("Type " + filter.Pattern + " is not defined\n").c_str());
+}
+
 //______________________________________________________________________________
 void TypedefPrinter::ProcessNestedDeclarations(const DeclContext* decl)const
 {
@@ -1537,6 +1890,63 @@ void DisplayClass(llvm::raw_ostream& stream, const Interpreter* interpreter,
   }
 }
 
+//______________________________________________________________________________
+bool DisplayFilter::parse(llvm::StringRef arg, DisplayFilter& filter)
+{
+  arg = arg.trim();
+
+  //A trailing "first", "first:count" or ":count" selects a page.
+  size_t first = 0, count = 0;
+  bool paged = false;
+  const size_t space = arg.find_last_of(" \t");
+  if (space != llvm::StringRef::npos) {
+    llvm::StringRef page = arg.substr(space + 1);
+    const std::pair<llvm::StringRef, llvm::StringRef> range = page.split(':');
+    if ((range.first.empty() || !range.first.getAsInteger(10, first))
+        && (range.second.empty() || !range.second.getAsInteger(10, count))
+        && !page.empty() && page != ":") {
+      paged = true;
+      arg = arg.substr(0, space).rtrim();
+    } else {
+      first = count = 0;
+    }
+  }
+
+  std::string scope, pattern;
+  bool isRegex = false;
+  if (arg.size() >= 2 && arg.front() == '/' && arg.back() == '/') {
+    pattern = arg.drop_front().drop_back().str();
+    isRegex = true;
+  } else {
+    const size_t scopeEnd = arg.rfind("::");
+    if (scopeEnd != llvm::StringRef::npos) {
+      scope = arg.substr(0, scopeEnd).str();
+      pattern = arg.substr(scopeEnd + 2).str();
+    } else
+      pattern = arg.str();
+    if (!paged && pattern.find_first_of("*?") == std::string::npos)
+      return false;
+  }
+
+  filter.Scope = scope;
+  filter.Pattern = pattern;
+  filter.IsRegex = isRegex;
+  filter.First = first;
+  filter.Count = count;
+  return true;
+}
+
+//______________________________________________________________________________
+void DisplayClasses(llvm::raw_ostream& stream, const Interpreter* interpreter,
+                    const DisplayFilter& filter, bool verbose)
+{
+  assert(interpreter != nullptr && "DisplayClasses, 'interpreter' parameter is null");
+
+  ClassPrinter printer(stream, interpreter);
+  printer.SetVerbose(verbose);
+  printer.DisplayClasses(filter);
+}
+
 //______________________________________________________________________________
 void DisplayNamespaces(llvm::raw_ostream &stream, const Interpreter *interpreter)
 {
@@ -1559,6 +1969,16 @@ void DisplayGlobals(llvm::raw_ostream& stream, const Interpreter* interpreter)
   printer.DisplayGlobals();
 }
 
+//______________________________________________________________________________
+void DisplayGlobals(llvm::raw_ostream& stream, const Interpreter* interpreter,
+                    const DisplayFilter& filter)
+{
+  assert(interpreter != nullptr && "DisplayGlobals, 'interpreter' parameter is null");
+
+  GlobalsPrinter printer(stream, interpreter);
+  printer.DisplayGlobals(filter);
+}
+
 //______________________________________________________________________________
 void DisplayGlobal(llvm::raw_ostream& stream, const Interpreter* interpreter,
                    const std::string& name)
@@ -1582,6 +2002,16 @@ void DisplayTypedefs(llvm::raw_ostream &stream, const Interpreter *interpreter)
    printer.DisplayTypedefs();
 }
 
+//______________________________________________________________________________
+void DisplayTypedefs(llvm::raw_ostream &stream, const Interpreter *interpreter,
+                     const DisplayFilter &filter)
+{
+   assert(interpreter != nullptr && "DisplayTypedefs, parameter 'interpreter' is null");
+
+   TypedefPrinter printer(stream, interpreter);
+   printer.DisplayTypedefs(filter);
+}
+
 //______________________________________________________________________________
 void DisplayTypedef(llvm::raw_ostream &stream, const Interpreter *interpreter,
                     const std::string &name)
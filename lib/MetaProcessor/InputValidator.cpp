@@ -20,7 +20,18 @@ namespace cling {
   InputValidator::ValidationResult
   InputValidator::validate(llvm::StringRef line) {
     ValidationResult Res = kComplete;
-    MetaLexer Lex(line.data(), /*skipWhiteSpace=*/true);
+
+    // Store the line first and lex it in place. The lexer runs up to the
+    // terminating NUL; lexing m_Input's tail bounds it to the new line even
+    // when `line` points into a larger buffer, e.g. a paste or a file fed
+    // line by line, which would otherwise be re-lexed up to its end for
+    // every line.
+    if (!m_Input.empty())
+      m_Input += '\n';
+    const size_t lineStart = m_Input.size();
+    m_Input.append(line.begin(), line.end());
+    MetaLexer Lex(llvm::StringRef(m_Input).substr(lineStart),
+                  /*skipWhiteSpace=*/true);
     Token Tok, lastNonSpaceTok;
 
     // Only check for 'template' if we're not already indented
@@ -103,10 +114,6 @@ namespace cling {
     if (Continue || (!m_ParenStack.empty() && Res != kMismatch))
       Res = kIncomplete;
 
-    if (!m_Input.empty()) {
-      m_Input.append("\n");
-    }
-    m_Input.append(line.str());
     m_LastResult = Res;
 
     return Res;
@@ -127,7 +127,8 @@ namespace cling {
       || isTypedefCommand()
       || isShellCommand(actionResult, resultValue) || isstoreStateCommand()
       || iscompareStateCommand() || isstatsCommand() || isundoCommand()
-      || isRedirectCommand(actionResult) || istraceCommand();
+      || isRedirectCommand(actionResult) || istraceCommand()
+      || ispgoCommand(actionResult);
   }
 
   // L := 'L' FilePath Comment
@@ -502,8 +503,10 @@ namespace cling {
       consumeToken();
       skipWhitespace();
       const Token& next = getCurTok();
-      m_Actions.actOnstatsCommand(what, next.is(tok::ident)
-                                         ? next.getIdent() : llvm::StringRef());
+      llvm::StringRef args;
+      if (next.is(tok::ident) || next.is(tok::constant))
+        args = llvm::StringRef(next.getBufStart(), next.getLength());
+      m_Actions.actOnstatsCommand(what, args);
       return true;
     }
     return false;
@@ -544,6 +547,34 @@ namespace cling {
     return false;
   }
 
+  // pgoCommand := 'pgo' [Constant] | 'pgo' 'optimize' [AnyString] |
+  //               'pgo' 'write' FilePath
+  bool MetaParser::ispgoCommand(MetaSema::ActionResult& actionResult) {
+    if (getCurTok().is(tok::ident) &&
+        getCurTok().getIdent().equals("pgo")) {
+      consumeToken();
+      skipWhitespace();
+      const Token& next = getCurTok();
+      if (next.is(tok::ident) && (next.getIdent().equals("optimize") ||
+                                  next.getIdent().equals("write"))) {
+        bool write = next.getIdent().equals("write");
+        consumeAnyStringToken(tok::eof);
+        llvm::StringRef arg;
+        if (getCurTok().is(tok::raw_ident))
+          arg = getCurTok().getIdent().trim();
+        actionResult = write ? m_Actions.actOnpgoWriteCommand(arg)
+                             : m_Actions.actOnpgoOptimizeCommand(arg);
+        return true;
+      }
+      MetaSema::SwitchMode mode = MetaSema::kToggle;
+      if (next.is(tok::constant))
+        mode = (MetaSema::SwitchMode)next.getConstantAsBool();
+      m_Actions.actOnpgoCommand(mode);
+      return true;
+    }
+    return false;
+  }
+
   bool MetaParser::isdynamicExtensionsCommand() {
     if (getCurTok().is(tok::ident) &&
         getCurTok().getIdent().equals("dynamicExtensions")) {
@@ -617,11 +648,11 @@ namespace cling {
 
   bool MetaParser::isgCommand() {
     if (getCurTok().is(tok::ident) && getCurTok().getIdent().equals("g")) {
-      consumeToken();
-      skipWhitespace();
+      // Take the rest of the line: it can be a filter such as "f*" or "/re/".
+      consumeAnyStringToken(tok::eof);
       llvm::StringRef varName;
-      if (getCurTok().is(tok::ident))
-        varName = getCurTok().getIdent();
+      if (getCurTok().is(tok::raw_ident))
+        varName = getCurTok().getIdent().trim();
       m_Actions.actOngCommand(varName);
       return true;
     }
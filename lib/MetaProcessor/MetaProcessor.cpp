@@ -16,6 +16,7 @@
 #include "cling/Interpreter/Interpreter.h"
 #include "cling/Interpreter/Value.h"
 #include "cling/Utils/Output.h"
+#include "cling/Utils/SourceNormalization.h"
 
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/TargetInfo.h"
@@ -23,10 +24,10 @@
 #include "clang/Lex/Preprocessor.h"
 
 #include "llvm/BinaryFormat/Magic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 
 #include <fcntl.h>
-#include <fstream>
 #include <cstdlib>
 #include <cctype>
 #include <sstream>
@@ -284,7 +285,14 @@ namespace cling {
   }
 
   MetaProcessor::MetaProcessor(Interpreter& interp, raw_ostream& outs)
-    : m_Interp(interp), m_Outs(&outs) {
+    : m_Interp(interp), m_Outs(&outs), m_ChunkThreshold(size_t(64) << 20),
+      m_ChunkSize(size_t(1) << 20) {
+    // Lets the chunking be exercised on small files, too.
+    if (const char* ChunkSizeEnvvar = std::getenv("CLING_FILE_CHUNK_SIZE")) {
+      // std::strtoull() returns 0 if the parsing fails.
+      if (const size_t ChunkSize = std::strtoull(ChunkSizeEnvvar, nullptr, 0))
+        m_ChunkThreshold = m_ChunkSize = ChunkSize;
+    }
     m_InputValidator.reset(new InputValidator());
     m_MetaSema.reset(new MetaSema(interp, *this));
   }
@@ -369,70 +377,72 @@ namespace cling {
                                    Value* result,
                                    size_t posOpenCurly,
                                    bool lineByLine) {
+    // Large files are mapped rather than read. Splitting them into chunks
+    // lexes the buffer, which needs the terminating NUL.
+    auto BufOrErr = llvm::MemoryBuffer::getFile(filename, /*IsText*/ false,
+                                                /*RequiresNullTerminator*/ true);
+    if (!BufOrErr)
+      return reportIOErr(filename, "open");
+    const llvm::StringRef buffer = (*BufOrErr)->getBuffer();
 
     // FIXME: This will fail for Unicode BOMs (and seems really weird)
     {
       // check that it's not binary:
-      std::ifstream in(filename.str().c_str(), std::ios::in | std::ios::binary);
-      if (in.fail())
-        return reportIOErr(filename, "open");
-
-      char magic[1024] = {0};
-      in.read(magic, sizeof(magic));
-      size_t readMagic = in.gcount();
+      llvm::StringRef magic = buffer.take_front(1024);
       // Binary files < 300 bytes are rare, and below newlines etc make the
-      // heuristic unreliable.
-      if (!in.fail() && readMagic >= 300) {
-        llvm::StringRef magicStr(magic,in.gcount());
-        llvm::file_magic fileType
-          = llvm::identify_magic(magicStr);
+      // heuristic unreliable; only files filling the probe are checked.
+      if (magic.size() == 1024) {
+        llvm::file_magic fileType = llvm::identify_magic(magic);
         if (fileType != llvm::file_magic::unknown &&
             fileType != llvm::file_magic::tapi_file)
           return reportIOErr(filename, "read from binary");
 
         unsigned printable = 0;
-        for (size_t i = 0; i < readMagic; ++i)
-          if (isprint(magic[i]))
+        for (char c : magic)
+          if (isprint(c))
             ++printable;
-        if (10 * printable <  5 * readMagic) {
+        if (10 * printable <  5 * magic.size()) {
           // 50% printable for ASCII files should be a safe guess.
           return reportIOErr(filename, "won't read from likely binary");
         }
       }
     }
 
-    // Windows requires std::ifstream::binary to properly handle
-    // CRLF and LF line endings
-    std::ifstream in(filename.str().c_str(), std::ifstream::binary);
-    if (in.fail())
-      return reportIOErr(filename, "open");
-
-    in.seekg(0, std::ios::end);
-    if (in.fail())
-      return reportIOErr(filename, "seek");
-
-    size_t size = in.tellg();
-    if (in.fail())
-      return reportIOErr(filename, "tell");
-
-    in.seekg(0);
-    if (in.fail())
-      return reportIOErr(filename, "rewind");
+    static const char whitespace[] = " \t\r\n";
 
-    std::string content(size, ' ');
-    in.read(&content[0], size);
-    if (in.fail())
-      return reportIOErr(filename, "read");
+    // Huge (typically generated) files are processed in chunks ending at top
+    // level statements, each compiled and run before the next one is parsed.
+    // For unnamed macros the chunks cover the text between the outer curly
+    // braces; if the closing one is not the last token, fall back to the
+    // handling below.
+    bool chunked = !lineByLine && buffer.size() >= m_ChunkThreshold;
+    size_t chunkScan = 0, chunkEnd = buffer.size();
+    if (chunked && posOpenCurly != (size_t)-1) {
+      size_t posCloseCurly = buffer.find_last_not_of(whitespace);
+      if (posCloseCurly != llvm::StringRef::npos && posCloseCurly > 0
+          && buffer[posCloseCurly] == ';' && buffer[posCloseCurly-1] == '}')
+        --posCloseCurly;
+      if (posCloseCurly == llvm::StringRef::npos
+          || posCloseCurly <= posOpenCurly || buffer[posCloseCurly] != '}')
+        chunked = false;
+      else {
+        chunkScan = posOpenCurly + 1;
+        chunkEnd = posCloseCurly;
+      }
+    }
 
-    static const char whitespace[] = " \t\r\n";
-    if (content.length() > 2 && content[0] == '#' && content[1] == '!') {
-      // Convert shebang line to comment. That's nice because it doesn't
-      // change the content size, leaving posOpenCurly untouched.
-      content[0] = '/';
-      content[1] = '/';
+    std::string content;
+    if (!chunked) {
+      content = buffer.str();
+      if (content.length() > 2 && content[0] == '#' && content[1] == '!') {
+        // Convert shebang line to comment. That's nice because it doesn't
+        // change the content size, leaving posOpenCurly untouched.
+        content[0] = '/';
+        content[1] = '/';
+      }
     }
 
-    if (posOpenCurly != (size_t)-1 && !content.empty()) {
+    if (!chunked && posOpenCurly != (size_t)-1 && !content.empty()) {
       assert(content[posOpenCurly] == '{'
              && "No curly at claimed position of opening curly!");
       // hide the curly brace:
@@ -489,15 +499,45 @@ namespace cling {
       p += 2;
     }
 #endif
-    content.insert(0, "#line 2 \"" + path + "\" \n");
-    // We don't want to value print the results of a unnamed macro.
-    if (content.back() != ';')
-      content.append(";");
+    if (!chunked) {
+      content.insert(0, "#line 2 \"" + path + "\" \n");
+      // We don't want to value print the results of a unnamed macro.
+      if (content.back() != ';')
+        content.append(";");
+    }
 
     Interpreter::InputFlagsRAII RAII(m_Interp, Interpreter::kInputFromFile |
                                                (lineByLine ? Interpreter::kIFFLineByLine : 0));
     Interpreter::CompilationResult ret = Interpreter::kSuccess;
-    if (lineByLine) {
+    if (chunked) {
+      const clang::LangOptions& LangOpts = m_Interp.getCI()->getLangOpts();
+      size_t line = 1;
+      for (size_t begin = 0; begin < chunkEnd;) {
+        const size_t end = utils::getChunkEnd(buffer, chunkScan, chunkEnd,
+                                              m_ChunkSize, LangOpts);
+        const std::string lineDirective
+          = "#line " + std::to_string(line + 1) + " \"" + path + "\" \n";
+        content = lineDirective;
+        content.append(buffer.data() + begin, end - begin);
+        if (begin == 0) {
+          // Hide the shebang and the unnamed macro's '{' as below.
+          if (buffer.starts_with("#!"))
+            content.replace(lineDirective.size(), 2, "//");
+          if (posOpenCurly != (size_t)-1)
+            content[lineDirective.size() + posOpenCurly] = ' ';
+        }
+        // We don't want to value print the results of a unnamed macro.
+        if (content.back() != ';')
+          content.append(";");
+
+        line += buffer.slice(begin, end).count('\n');
+        begin = chunkScan = end;
+
+        ret = m_Interp.process(content, result);
+        if (ret != Interpreter::kSuccess)
+          break;
+      }
+    } else if (lineByLine) {
       int rslt = 0;
       std::string line;
       std::stringstream ss(content);
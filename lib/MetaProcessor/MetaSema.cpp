@@ -101,6 +101,12 @@ namespace cling {
 
   MetaSema::ActionResult MetaSema::actOnTCommand(llvm::StringRef inputFile,
                                                  llvm::StringRef outputFile) {
+    // A .idx output selects the binary, memory-mappable index.
+    if (outputFile.ends_with(".idx")) {
+      std::string Header = inputFile.str();
+      return m_Interpreter.GenerateAutoloadIndex(Header, outputFile)
+        ? AR_Success : AR_Failure;
+    }
     m_Interpreter.GenerateAutoLoadingMap(inputFile, outputFile);
     return AR_Success;
   }
@@ -313,6 +319,34 @@ namespace cling {
       m_Interpreter.enableDynamicLookup(mode);
   }
 
+  void MetaSema::actOnpgoCommand(SwitchMode mode/* = kToggle*/) const {
+    if (mode == kToggle) {
+      bool flag = !m_Interpreter.isProfileInstrumentationEnabled();
+      m_Interpreter.enableProfileInstrumentation(flag);
+      m_MetaProcessor.getOuts()
+        << (flag ? "I" : "Not i") << "nstrumenting new code for PGO\n";
+    }
+    else
+      m_Interpreter.enableProfileInstrumentation(mode);
+  }
+
+  MetaSema::ActionResult
+  MetaSema::actOnpgoOptimizeCommand(llvm::StringRef function) const {
+    unsigned N = m_Interpreter.reoptimizeWithProfile(function);
+    m_MetaProcessor.getOuts() << "Re-optimized " << N << " function"
+                              << (N == 1 ? "" : "s") << "\n";
+    return N ? AR_Success : AR_Failure;
+  }
+
+  MetaSema::ActionResult
+  MetaSema::actOnpgoWriteCommand(llvm::StringRef file) const {
+    if (file.empty()) {
+      m_MetaProcessor.getOuts() << "Missing file name for the profile\n";
+      return AR_Failure;
+    }
+    return m_Interpreter.writeProfile(file) ? AR_Success : AR_Failure;
+  }
+
   void MetaSema::actOnhelpCommand() const {
     std::string& metaString = m_Interpreter.getOptions().MetaString;
     llvm::raw_ostream& outs = m_MetaProcessor.getOuts();
@@ -349,6 +383,11 @@ namespace cling {
       "   " << metaString << "Class <name>\t\t- Prints out class <name> in a CINT-like style (all-levels).\n"
                              "\t\t\t\t  If no name is given, prints out list of all classes.\n"
       "\n"
+      "   " << metaString << "class <filter>\t\t- Lists the classes matching <filter>:\n"
+                             "\t\t\t\t  '[scope::]name*' (wildcards '*', '?') or '/regex/',\n"
+                             "\t\t\t\t  optionally followed by a page 'first[:count]'.\n"
+                             "\t\t\t\t  Also for .g and .typedef.\n"
+      "\n"
       "   " << metaString << "namespace\t\t\t- Prints list of all known namespaces\n"
       "\n"
       "   " << metaString << "typedef <name>\t\t- Prints out typedef <name> in a CINT-like style\n"
@@ -372,6 +411,11 @@ namespace cling {
       "\n"
       "   " << metaString << "debug <level>\t\t- Generates debug symbols (level is optional, 0 to disable)\n"
       "\n"
+      "   " << metaString << "pgo [0|1]\t\t\t- Toggles the profile instrumentation of new code\n"
+      "   " << metaString << "pgo optimize [func]\t- Re-optimizes executed instrumented functions"
+                             "\n\t\t\t\t  with the collected profile (all if none is given)\n"
+      "   " << metaString << "pgo write <filename>\t- Writes the collected profile as .profdata\n"
+      "\n"
       "   " << metaString << "printDebug [0|1]\t\t- Toggles the printing of input's corresponding"
                              "\n\t\t\t\t  state changes\n"
       "\n"
@@ -384,9 +428,12 @@ namespace cling {
                              "\t\t\t\t  'ast'  abstract syntax tree stats\n"
                              "\t\t\t\t  'asttree [filter]'  abstract syntax tree layout\n"
                              "\t\t\t\t  'decl' dump ast declarations\n"
+                             "\t\t\t\t  'memory [N]' the N transactions using the most memory\n"
+                             "\t\t\t\t  'transformers' time spent in AST transformers\n"
                              "\t\t\t\t  'undo' show undo stack\n"
       "\n"
       "   " << metaString << "T <filePath> <comment>\t- Generate autoload map\n"
+                             "\t\t\t\t  (a binary index if <comment> ends in .idx)\n"
       "\n"
       "   " << metaString << "trace <repr> <id>\t\t- Dump trace of requested respresentation\n"
                              "\t\t\t\t  (see " << metaString << "stats arguments for <repr>)\n"
@@ -433,6 +480,10 @@ namespace cling {
   }
 
   void MetaSema::actOnClassCommand(llvm::StringRef className, bool verbose) const {
+    DisplayFilter filter;
+    if (DisplayFilter::parse(className, filter))
+      DisplayClasses(m_MetaProcessor.getOuts(), &m_Interpreter, filter, verbose);
+    else
       DisplayClass(m_MetaProcessor.getOuts(),
                    &m_Interpreter, className.str().c_str(), verbose);
   }
@@ -442,16 +493,22 @@ namespace cling {
   }
 
   void MetaSema::actOngCommand(llvm::StringRef varName) const {
+    DisplayFilter filter;
     if (varName.empty())
       DisplayGlobals(m_MetaProcessor.getOuts(), &m_Interpreter);
+    else if (DisplayFilter::parse(varName, filter))
+      DisplayGlobals(m_MetaProcessor.getOuts(), &m_Interpreter, filter);
     else
       DisplayGlobal(m_MetaProcessor.getOuts(),
                     &m_Interpreter, varName.str().c_str());
   }
 
   void MetaSema::actOnTypedefCommand(llvm::StringRef typedefName) const {
+    DisplayFilter filter;
     if (typedefName.empty())
       DisplayTypedefs(m_MetaProcessor.getOuts(), &m_Interpreter);
+    else if (DisplayFilter::parse(typedefName, filter))
+      DisplayTypedefs(m_MetaProcessor.getOuts(), &m_Interpreter, filter);
     else
       DisplayTypedef(m_MetaProcessor.getOuts(),
                      &m_Interpreter, typedefName.str().c_str());
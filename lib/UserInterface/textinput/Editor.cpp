@@ -111,24 +111,16 @@ namespace textinput {
   Editor::UpdateHistSearch(EditorRange& R) {
     History* Hist = fContext->GetHistory();
     Text& Line = fContext->GetLine();
-    std::ptrdiff_t NewHistEntry = -1;
     if (fSearch.empty())
       return true;
-    std::ptrdiff_t startAt = fCurHistEntry;
-    if (startAt == -1) {
+    size_t startAt = fCurHistEntry;
+    if (startAt == static_cast<size_t>(-1)) {
       startAt = 0;
     }
-    const std::ptrdiff_t stopAt = (fMode == kHistFwdSearchMode)
-                                    ? -1 : static_cast<std::ptrdiff_t>(Hist->GetSize());
-    const std::ptrdiff_t step = (fMode == kHistFwdSearchMode ? -1 : 1);
-    for (std::ptrdiff_t i = startAt; i != stopAt; i += step) {
-      if (Hist->GetLine(i).find(fSearch) != std::string::npos) {
-        NewHistEntry = i;
-        break;
-      }
-    }
+    size_t NewHistEntry = Hist->Find(fSearch, startAt,
+                                     fMode != kHistFwdSearchMode);
 
-    if (NewHistEntry != -1) {
+    if (NewHistEntry != static_cast<size_t>(-1)) {
       // No, even if they are unchanged: we might have
       // subsequent ^R or ^S updates triggered by faking a different
       // fCurHistEntry.
@@ -178,7 +170,8 @@ namespace textinput {
       return kPRError;
     }
 
-    PushUndo();
+    if (!fInPaste)
+      PushUndo();
     ClearPasteBuf();
 
     Text& Line = fContext->GetLine();
@@ -478,6 +471,14 @@ namespace textinput {
         // Already done for all commands:
         //CancelSpecialInputMode(R);
         return kPRSuccess;
+      case kCmdPasteBegin:
+        // The pasted characters are undone together.
+        PushUndo();
+        fInPaste = true;
+        return kPRSuccess;
+      case kCmdPasteEnd:
+        fInPaste = false;
+        return kPRSuccess;
       case kCmdComplete:
       {
         // Completion happens below current input.
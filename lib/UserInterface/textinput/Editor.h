@@ -78,6 +78,8 @@ namespace textinput {
       kCmdUndo,
 
       kCmdEsc,
+      kCmdPasteBegin, // terminal starts sending pasted text
+      kCmdPasteEnd, // end of pasted text
       kCmdIgnore // ignore this command, e.g. because it was already processed
     };
 
@@ -124,7 +126,8 @@ namespace textinput {
 
     Editor(TextInputContext* C):
       fContext(C), fCurHistEntry((size_t)-1), fReplayHistEntry((size_t)-1),
-      fMode(kInputMode), fOverwrite(false), fCutDirection(0) {}
+      fMode(kInputMode), fOverwrite(false), fInPaste(false),
+      fCutDirection(0) {}
     ~Editor() {}
 
     Range ResetText();
@@ -166,6 +169,7 @@ namespace textinput {
     size_t fReplayHistEntry; // set next line to this hist entry, kCmdHistReplay
     EEditMode fMode; // current input mode
     bool fOverwrite; // Insert of overwrite
+    bool fInPaste; // within a bracketed paste; one undo step for all of it
     int fCutDirection; // cutting forward or wackward - change clears pastbuf
     std::deque<std::pair<Text /*Line*/, size_t /*Cursor*/> > fUndoBuf; // undos
   };
@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "textinput/History.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -25,10 +26,20 @@ extern "C" unsigned long __stdcall GetCurrentProcessId(void);
 # include <unistd.h>
 #endif
 
+namespace {
+  // Length of the substrings indexed for history search.
+  const size_t kGramLength = 3;
+
+  unsigned Trigram(const char* s) {
+    return ((unsigned)(unsigned char)s[0] << 16)
+      | ((unsigned)(unsigned char)s[1] << 8) | (unsigned char)s[2];
+  }
+}
+
 namespace textinput {
   History::History(const char* filename):
     fHistFileName(filename ? filename : ""), fMaxDepth((size_t) -1),
-    fPruneLength(0), fNumHistFileLines(0) {
+    fPruneLength(0), fNumHistFileLines(0), fNumIndexed(0) {
     // Create a history object, initialize from filename if the file
     // exists. Append new lines to filename taking into account the
     // maximal number of lines allowed by SetMaxDepth().
@@ -66,6 +77,77 @@ namespace textinput {
     fNumHistFileLines = fEntries.size();
   }
 
+  size_t
+  History::Find(const std::string& Needle, size_t Idx, bool Older) const {
+    // fEntries is oldest first, Idx counts from the newest line.
+    const size_t N = fEntries.size();
+    if (Idx >= N) return (size_t) -1;
+    const size_t Pos = N - 1 - Idx;
+
+    // Only lines containing the rarest of Needle's trigrams need a look.
+    const PostingList* Candidates = nullptr;
+    if (Needle.length() >= kGramLength) {
+      UpdateIndex();
+      for (size_t i = 0; i + kGramLength <= Needle.length(); ++i) {
+        auto I = fIndex.find(Trigram(Needle.data() + i));
+        if (I == fIndex.end()) return (size_t) -1;
+        if (!Candidates || I->second.size() < Candidates->size())
+          Candidates = &I->second;
+      }
+    }
+
+    auto Matches = [&](size_t P) {
+      return fEntries[P].find(Needle) != std::string::npos;
+    };
+    if (!Candidates) {
+      // Too short for the index.
+      if (Older) {
+        for (size_t P = Pos + 1; P-- > 0;)
+          if (Matches(P)) return N - 1 - P;
+      } else {
+        for (size_t P = Pos; P < N; ++P)
+          if (Matches(P)) return N - 1 - P;
+      }
+    } else if (Older) {
+      PostingList::const_iterator I
+        = std::upper_bound(Candidates->begin(), Candidates->end(), Pos);
+      while (I != Candidates->begin()) {
+        --I;
+        if (Matches(*I)) return N - 1 - *I;
+      }
+    } else {
+      for (PostingList::const_iterator
+             I = std::lower_bound(Candidates->begin(), Candidates->end(), Pos),
+             E = Candidates->end(); I != E; ++I) {
+        if (Matches(*I)) return N - 1 - *I;
+      }
+    }
+    return (size_t) -1;
+  }
+
+  void
+  History::UpdateIndex() const {
+    // Index the lines added since the previous search.
+    for (; fNumIndexed < fEntries.size(); ++fNumIndexed) {
+      const std::string& Line = fEntries[fNumIndexed];
+      for (size_t i = 0; i + kGramLength <= Line.length(); ++i) {
+        PostingList& PL = fIndex[Trigram(Line.data() + i)];
+        if (PL.empty() || PL.back() != fNumIndexed)
+          PL.push_back(fNumIndexed);
+      }
+    }
+  }
+
+  size_t
+  History::CountFileLines() const {
+    std::ifstream in(fHistFileName.c_str(), std::ios_base::binary);
+    size_t nLines = 0;
+    char buf[64 * 1024];
+    while (in.read(buf, sizeof(buf)) || in.gcount())
+      nLines += std::count(buf, buf + in.gcount(), '\n');
+    return nLines;
+  }
+
   void
   History::AppendToFile() {
     // Write last entry to hist file.
@@ -85,55 +167,63 @@ namespace textinput {
     // enough.
     if (fNumHistFileLines < fMaxDepth
         && (fNumHistFileLines % (fMaxDepth - nPrune)) == 0) {
-      fNumHistFileLines = 0;
-      std::string line;
-      std::ifstream in(fHistFileName.c_str());
-      while (std::getline(in, line))
-        ++fNumHistFileLines;
+      fNumHistFileLines = CountFileLines();
+    }
+
+    if (fNumHistFileLines >= fMaxDepth) {
+      Prune(fNumHistFileLines, nPrune);
+      return;
+    }
+
+    // Reopen for every line: another process might have pruned the file,
+    // i.e. renamed a new one over it.
+    std::ofstream out(fHistFileName.c_str(), std::ios_base::app);
+    out << fEntries.back() << '\n';
+    ++fNumHistFileLines;
+  }
+
+  void
+  History::Prune(size_t numLines, size_t nPrune) {
+    // Prune! But don't simply write our lines - other processes might have
+    // added their own.
+    std::string Contents;
+    {
+      std::ifstream in(fHistFileName.c_str(), std::ios_base::binary);
+      std::ostringstream ss;
+      ss << in.rdbuf();
+      Contents = ss.str();
+    }
+    size_t Keep = 0;
+    while (numLines >= nPrune && Keep < Contents.length()) {
+      // skip
+      size_t EOL = Contents.find('\n', Keep);
+      Keep = EOL == std::string::npos ? Contents.length() : EOL + 1;
+      --numLines;
     }
 
-    size_t numLines = fNumHistFileLines;
-    if (numLines >= fMaxDepth) {
-      // Prune! But don't simply write our lines - other processes might have
-      // added their own.
-      std::string line;
-      std::ifstream in(fHistFileName.c_str());
-      std::stringstream pruneFileNameStream;
-      pruneFileNameStream << fHistFileName + "_prune"
+    std::stringstream pruneFileNameStream;
+    pruneFileNameStream << fHistFileName + "_prune"
 #if _WIN32
-                          << ::GetCurrentProcessId();
+                        << ::GetCurrentProcessId();
 #else
-                          << ::getpid();
+                        << ::getpid();
 #endif
-      std::ofstream out(pruneFileNameStream.str().c_str());
-      if (out) {
-        if (in) {
-          while (numLines >= nPrune && std::getline(in, line)) {
-            // skip
-            --numLines;
-          }
-          while (std::getline(in, line)) {
-            out << line << '\n';
-          }
-        }
-        out << fEntries.back() << '\n';
-        in.close();
-        out.close();
+    std::ofstream out(pruneFileNameStream.str().c_str(),
+                      std::ios_base::binary);
+    if (!out) return;
+    out.write(Contents.data() + Keep, Contents.length() - Keep);
+    out << fEntries.back() << '\n';
+    out.close();
+
 #ifdef WIN32
-        ::_unlink(fHistFileName.c_str());
+    ::_unlink(fHistFileName.c_str());
 #else
-        ::unlink(fHistFileName.c_str());
+    ::unlink(fHistFileName.c_str());
 #endif
-        if (::rename(pruneFileNameStream.str().c_str(), fHistFileName.c_str()) == -1){
-           std::cerr << "ERROR in textinput::History::AppendToFile(): "
-              "cannot rename " << pruneFileNameStream.str() << " to " << fHistFileName;
-        }
-        fNumHistFileLines = nPrune;
-      }
-    } else {
-      std::ofstream out(fHistFileName.c_str(), std::ios_base::app);
-      out << fEntries.back() << '\n';
-      ++fNumHistFileLines;
+    if (::rename(pruneFileNameStream.str().c_str(), fHistFileName.c_str()) == -1){
+       std::cerr << "ERROR in textinput::History::AppendToFile(): "
+          "cannot rename " << pruneFileNameStream.str() << " to " << fHistFileName;
     }
+    fNumHistFileLines = nPrune;
   }
 }
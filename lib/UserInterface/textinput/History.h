@@ -18,6 +18,7 @@
 
 #include <cstddef>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace textinput {
@@ -49,17 +50,32 @@ namespace textinput {
     void ModifyLine(size_t Idx, const char* line) {
       fEntries[fEntries.size() - 1 - Idx] = line;
       // Does not sync to file!
+      ResetIndex();
     }
 
+    // Index of the first line containing Needle, starting at Idx and going
+    // to older (or, if !Older, to newer) lines; -1 if none.
+    size_t Find(const std::string& Needle, size_t Idx, bool Older) const;
+
     void AppendToFile();
     void ReadFile(const char* FileName);
 
   private:
+    typedef std::vector<unsigned> PostingList;
+    void UpdateIndex() const;
+    void ResetIndex() { fIndex.clear(); fNumIndexed = 0; }
+    size_t CountFileLines() const;
+    void Prune(size_t numLines, size_t nPrune);
+
     std::string fHistFileName; // History file name
     size_t fMaxDepth; // Max number of entries before pruning
     size_t fPruneLength; // Remaining entries after pruning
     size_t fNumHistFileLines; // Hist file's number of lines at previous access
     std::vector<std::string> fEntries; // Previous input lines
+    // Trigram -> indices into fEntries (oldest first) of lines containing it.
+    // Built on the first search, then extended as lines get added.
+    mutable std::unordered_map<unsigned, PostingList> fIndex;
+    mutable size_t fNumIndexed; // Number of fEntries covered by fIndex
   };
 }
 
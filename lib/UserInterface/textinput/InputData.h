@@ -52,6 +52,8 @@ namespace textinput {
       kEIF12,
       kEIEOF,
       kEIResizeEvent,
+      kEIPasteBegin, // bracketed paste starts
+      kEIPasteEnd, // bracketed paste ends
       kEIIgnore
     };
 
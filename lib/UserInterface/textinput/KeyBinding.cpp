@@ -148,6 +148,8 @@ namespace textinput {
       case InputData::kEIIns: return C(Editor::kCmdToggleOverwriteMode);
       case InputData::kEITab: return C(Editor::kCmdComplete);
       case InputData::kEIEnter: return C(Editor::kCmdEnter);
+      case InputData::kEIPasteBegin: return C(Editor::kCmdPasteBegin);
+      case InputData::kEIPasteEnd: return C(Editor::kCmdPasteEnd);
       case InputData::kEIEsc:
         if (!fEscCmdEnabled) {
           // ESC can be CSI intro
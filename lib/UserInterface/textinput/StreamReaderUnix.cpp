@@ -17,6 +17,7 @@
 
 #include "textinput/StreamReaderUnix.h"
 
+#include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -43,23 +44,21 @@ namespace {
 
   class Rewind {
   public:
-    Rewind(std::queue<char>& rab, InputData::EExtendedInput& ret):
+    Rewind(std::deque<char>& rab, InputData::EExtendedInput& ret):
     RAB(rab), Ret(ret) {}
 
     ~Rewind() {
       if (Ret != InputData::kEIUninitialized) return;
       // RAB.push(0x1b); already handled by ProcessCSI returning false.
-      while (!Q.empty()) {
-        RAB.push(Q.front());
-        Q.pop();
-      }
+      // The chars were taken from the front of RAB; put them back there.
+      RAB.insert(RAB.begin(), Q.begin(), Q.end());
     }
 
-    void push(char C) { Q.push(C); }
+    void push(char C) { Q.push_back(C); }
 
   private:
-    std::queue<char> Q;
-    std::queue<char>& RAB;
+    std::deque<char> Q;
+    std::deque<char>& RAB;
     InputData::EExtendedInput& Ret;
   };
 
@@ -132,7 +131,7 @@ namespace {
 
 namespace textinput {
   StreamReaderUnix::StreamReaderUnix():
-    fHaveInputFocus(false), fIsTTY(isatty(fileno(stdin))) {
+    fHaveInputFocus(false), fIsTTY(isatty(fileno(stdin))), fInPaste(false) {
 #ifdef TCSANOW
     // ~ISTRIP - do not strip 8th char bit
     // ~IXOFF - software flow ctrl disabled for input queue
@@ -166,12 +165,22 @@ namespace textinput {
 
   ////////////////////////////////////////////////////////////////////////////////
   /// Detach from terminal, set the old configuration.
+  ///
+  /// Input that was read ahead but not processed is pushed back into the
+  /// terminal's input queue, so that the code run next can read it. Where the
+  /// terminal does not allow that (e.g. Linux with dev.tty.legacy_tiocsti=0),
+  /// it stays buffered for the next prompt.
   void
   StreamReaderUnix::ReleaseInputFocus() {
     // set to buffered
     if (!fHaveInputFocus) return;
     TerminalConfigUnix::Get().Detach();
     fHaveInputFocus = false;
+#ifdef TIOCSTI
+    while (!fReadAheadBuffer.empty()
+           && ioctl(fileno(stdin), TIOCSTI, &fReadAheadBuffer.front()) == 0)
+      fReadAheadBuffer.pop_front();
+#endif
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -216,6 +225,8 @@ namespace textinput {
       gExtKeyMap['[']['4']['~'] = InputData::kEIEnd;
       gExtKeyMap['[']['5']['~'] = InputData::kEIPgUp;
       gExtKeyMap['[']['6']['~'] = InputData::kEIPgDown;
+      gExtKeyMap['[']['2']['0']['0']['~'] = InputData::kEIPasteBegin;
+      gExtKeyMap['[']['2']['0']['1']['~'] = InputData::kEIPasteEnd;
       gExtKeyMap['[']['1'][';']['5']['A'].Set(InputData::kEIUp,
                                          InputData::kModCtrl);
       gExtKeyMap['[']['1'][';']['5']['B'].Set(InputData::kEIDown,
@@ -268,13 +279,18 @@ namespace textinput {
     int c = ReadRawCharacter();
     in.SetModifier(InputData::kModNone);
     if (c == -1) { // non-character value, EOF negative
+      fInPaste = false;
       in.SetExtended(InputData::kEIEOF);
+    } else if (fInPaste) {
+      ReadPastedInput(c, in);
     } else if (c == 0x1b) { // ESC
       // Only try to process CSI if Esc does not have a meaning by itself.
       // by itself.
       if (GetContext()->GetKeyBinding()->IsEscCommandEnabled()
           || !ProcessCSI(in)) {
         in.SetExtended(InputData::kEIEsc);
+      } else if (in.GetExtendedInput() == InputData::kEIPasteBegin) {
+        fInPaste = true;
       }
     } else if (isprint(c)) { // c >= 0x20(32) && c < 0x7f(127)
       in.SetRaw(c);
@@ -293,24 +309,61 @@ namespace textinput {
     return true;
   }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// Convert a character of a bracketed paste to InputData. Pasted text is
+  /// taken literally: key bindings (TAB completion, ^R,...) do not apply.
+  ///
+  /// \param[in] c the character read
+  /// \param[in] in input char / data to be filled out
+  void
+  StreamReaderUnix::ReadPastedInput(int c, InputData& in) {
+    if (c == 0x1b) {
+      // Anything but the end marker is dropped.
+      if (ProcessCSI(in) && in.GetExtendedInput() == InputData::kEIPasteEnd)
+        fInPaste = false;
+      else
+        in.SetExtended(InputData::kEIIgnore);
+    } else if (c == 13 || c == 10) {
+      in.SetExtended(InputData::kEIEnter);
+    } else if (c == '\t') {
+      in.SetRaw(' ');
+    } else if (c < 32 || c == 127) {
+      in.SetExtended(InputData::kEIIgnore);
+    } else {
+      in.SetRaw(c);
+    }
+  }
+
   ////////////////////////////////////////////////////////////////////////////////
   /// Read one character from stdin. Block if not available.
+  ///
+  /// For a tty, whatever else is already available (e.g. a paste) is read
+  /// along with it and buffered; a paste then costs one read() instead of one
+  /// per character. Nothing is read that has not arrived yet, and what is left
+  /// over when the input is taken is pushed back by ReleaseInputFocus(). Other
+  /// input is read char by char, to not swallow what the interpreted code
+  /// reads from stdin.
   int
   StreamReaderUnix::ReadRawCharacter() {
-    char buf;
-    if (!fReadAheadBuffer.empty()) {
-      buf = fReadAheadBuffer.front();
-      fReadAheadBuffer.pop();
-    } else {
-      ssize_t ret = read(fileno(stdin), &buf, 1);
+    if (fReadAheadBuffer.empty()) {
+      char buf[4096];
+      ssize_t ret = read(fileno(stdin), buf, 1);
 #ifdef __APPLE__
       // Allow a debugger to be attached and used on OS X.
       while (ret == -1 && errno == EINTR)
-        ret = read(fileno(stdin), &buf, 1);
+        ret = read(fileno(stdin), buf, 1);
 #endif
-      if (ret != 1) return -1;
+      if (ret < 1) return -1;
+      if (fIsTTY && HavePendingInput(false)) {
+        ssize_t more = read(fileno(stdin), buf + 1, sizeof(buf) - 1);
+        if (more > 0)
+          ret += more;
+      }
+      fReadAheadBuffer.insert(fReadAheadBuffer.end(), buf, buf + ret);
     }
-    return buf;
+    char c = fReadAheadBuffer.front();
+    fReadAheadBuffer.pop_front();
+    return c;
   }
 }
 
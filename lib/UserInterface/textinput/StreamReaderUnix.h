@@ -18,7 +18,7 @@
 
 #include "textinput/StreamReader.h"
 #include <cstddef>
-#include <queue>
+#include <deque>
 
 namespace textinput {
   class InputData;
@@ -40,10 +40,12 @@ namespace textinput {
   private:
     int ReadRawCharacter();
     bool ProcessCSI(InputData& in);
+    void ReadPastedInput(int c, InputData& in);
 
     bool fHaveInputFocus; // whether we configured the tty
     bool fIsTTY; // whether input FD is a tty
-    std::queue<char> fReadAheadBuffer; // input chars we read too much (CSI)
+    bool fInPaste; // between bracketed paste start and end markers
+    std::deque<char> fReadAheadBuffer; // input chars read but not processed
   };
 }
 
@@ -49,6 +49,7 @@ namespace textinput {
     WriteWrapped(r.fPromptUpdate, GetContext()->GetTextInput()->IsInputMasked(),
       r.fStart, r.fLength);
     Move(GetCursor());
+    Flush();
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -57,6 +58,7 @@ namespace textinput {
   TerminalDisplay::NotifyCursorChange() {
     Attach();
     Move(GetCursor());
+    Flush();
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -70,6 +72,7 @@ namespace textinput {
     }
     fWriteLen = 0;
     fWritePos = Pos();
+    Flush();
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -79,6 +82,7 @@ namespace textinput {
   TerminalDisplay::NotifyError() {
     Attach();
     WriteRawString("\x07", 1);
+    Flush();
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -101,6 +105,7 @@ namespace textinput {
     // Reset position
     Detach();
     Attach();
+    Flush();
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -117,6 +122,7 @@ namespace textinput {
       // We can't tell whether the application will activate a different color:
       fPrevColor = -1;
     }
+    Flush();
   }
 
   ////////////////////////////////////////////////////////////////////////////////
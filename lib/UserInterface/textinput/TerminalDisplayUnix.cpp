@@ -24,6 +24,7 @@
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <termios.h>
+#include <cerrno>
 #include <csignal>
 #include <cstring>
 #include <sstream>
@@ -129,6 +130,7 @@ namespace textinput {
 
   TerminalDisplayUnix::~TerminalDisplayUnix() {
     Detach();
+    Flush();
     if (fOutputID != STDOUT_FILENO) {
       SYNC_OUT(fOutputID);
       ::close(fOutputID);
@@ -168,6 +170,7 @@ namespace textinput {
     static const char text[] = "\033[2J\033[H";
     if (!IsTTY()) return;
     WriteRawString(text, sizeof(text));
+    Flush();
   }
 
   void
@@ -261,15 +264,35 @@ namespace textinput {
   }
 
   ////////////////////////////////////////////////////////////////////////////////
-  /// Writes out a raw string to stdout.
+  /// Queues a raw string for output to stdout; see Flush().
   ///
   /// \param[in] text raw string to be written out
   /// \param[in] len length of the raw string
   void
   TerminalDisplayUnix::WriteRawString(const char *text, size_t len) {
-    if (write(fOutputID, text, len) == -1) {
-      // Silence Ubuntu's "unused result". We don't care if it fails.
+    fPendingOutput.append(text, len);
+    if (fPendingOutput.size() > 16 * 1024)
+      Flush();
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// Writes out the queued output. A redraw is assembled from many cursor
+  /// moves, color changes and text chunks; sending it with one write() keeps
+  /// the number of syscalls and of packets on remote connections down.
+  void
+  TerminalDisplayUnix::Flush() {
+    const char* text = fPendingOutput.data();
+    size_t len = fPendingOutput.size();
+    while (len) {
+      ssize_t ret = write(fOutputID, text, len);
+      if (ret == -1 && errno == EINTR)
+        continue;
+      if (ret <= 0)
+        break; // We don't care if it fails.
+      text += ret;
+      len -= ret;
     }
+    fPendingOutput.clear();
   }
 
   ////////////////////////////////////////////////////////////////////////////////
@@ -291,12 +314,20 @@ namespace textinput {
     fWritePos = Pos();
     fWriteLen = 0;
     fIsAttached = true;
+    // Ask the terminal to bracket pasted text by ESC[200~ / ESC[201~, see
+    // StreamReaderUnix::ReadPastedInput().
+    if (IsTTY()) {
+      WriteRawString("\033[?2004h", 8);
+      Flush();
+    }
   }
 
   void
   TerminalDisplayUnix::Detach() {
     if (!fIsAttached) return;
     SYNC_OUT(fOutputID);
+    if (IsTTY())
+      WriteRawString("\033[?2004l", 8);
     TerminalConfigUnix::Get().Detach();
     TerminalDisplay::Detach();
     fIsAttached = false;
@@ -17,6 +17,7 @@
 #define TEXTINPUT_TERMINALDISPLAYUNIX_H
 
 #include <cstddef>
+#include <string>
 #include "textinput/TerminalDisplay.h"
 
 namespace textinput {
@@ -43,6 +44,7 @@ namespace textinput {
     void MoveFront() override;
     void SetColor(char CIdx, const Color& C) override;
     void WriteRawString(const char* text, size_t len) override;
+    void Flush() override;
     void ActOnEOL() override;
     void EraseToRight() override;
     int GetClosestColorIdx256(const Color& C);
@@ -52,6 +54,7 @@ namespace textinput {
     bool fIsAttached; // whether tty is configured
     size_t fNColors; // number of colors supported by output
     int fOutputID; // Prompt output file descriptor
+    std::string fPendingOutput; // written by Flush(), one write() per redraw
   };
 }
 #endif // TEXTINPUT_TERMINALDISPLAYUNIX_H
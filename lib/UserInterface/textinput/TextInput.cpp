@@ -124,9 +124,13 @@ namespace textinput {
              || (*iR)->HaveBufferedInput()) {
         if ((*iR)->ReadInput(nRead, in)) {
           ProcessNewInput(in, R);
-          DisplayNewInput(R, OldCursorPos);
-          if (fLastReadResult == kRREOF
-              || fLastReadResult == kRRReadEOLDelimiter)
+          bool AtEnd = fLastReadResult == kRREOF
+            || fLastReadResult == kRRReadEOLDelimiter;
+          // Redraw once the reader has drained what it got in one go, e.g.
+          // a paste: not once per character.
+          if (AtEnd || !(*iR)->HaveBufferedInput())
+            DisplayNewInput(R, OldCursorPos);
+          if (AtEnd)
             break;
         }
       }
@@ -204,6 +208,8 @@ namespace textinput {
     }
 
     oldCursorPos = fContext->GetCursor();
+    // What was changed has been displayed.
+    R = EditorRange();
   }
 
   void
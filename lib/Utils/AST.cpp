@@ -17,10 +17,12 @@
 #include "clang/AST/DeclTemplate.h"
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringRef.h"
 #include "clang/AST/Mangle.h"
 
 #include <memory>
+#include <mutex>
 #include <stdio.h>
 
 using namespace clang;
@@ -64,6 +66,67 @@ namespace utils {
   NestedNameSpecifier* GetFullyQualifiedNameSpecifier(const ASTContext& Ctx,
                                                       NestedNameSpecifier* scope);
 
+  namespace {
+    ///\brief Memoized type normalizations of one ASTContext. The types are
+    /// allocated by (and live as long as) the ASTContext, which also deletes
+    /// the cache when it goes away.
+    struct TypeNameCache {
+      llvm::DenseMap<const void*, QualType> FullyQualifiedTypes;
+      llvm::DenseMap<const void*, std::string> FullyQualifiedNames;
+      /// Keyed by type and fingerprint of the Transform::Config.
+      llvm::DenseMap<std::pair<const void*, uint64_t>, QualType> Desugared;
+
+      void clear() {
+        FullyQualifiedTypes.clear();
+        FullyQualifiedNames.clear();
+        Desugared.clear();
+      }
+
+      static std::mutex& getMutex() {
+        static std::mutex M;
+        return M;
+      }
+      static llvm::DenseMap<const ASTContext*, TypeNameCache*>& getCaches() {
+        static llvm::DenseMap<const ASTContext*, TypeNameCache*> Caches;
+        return Caches;
+      }
+
+      static void destroy(void* Ctx) {
+        std::lock_guard<std::mutex> Lock(getMutex());
+        auto I = getCaches().find(static_cast<const ASTContext*>(Ctx));
+        if (I == getCaches().end())
+          return;
+        delete I->second;
+        getCaches().erase(I);
+      }
+
+      static TypeNameCache& get(const ASTContext& Ctx) {
+        std::lock_guard<std::mutex> Lock(getMutex());
+        TypeNameCache*& Cache = getCaches()[&Ctx];
+        if (!Cache) {
+          Cache = new TypeNameCache();
+          Ctx.AddDeallocation(&TypeNameCache::destroy,
+                              const_cast<ASTContext*>(&Ctx));
+        }
+        return *Cache;
+      }
+    };
+  } // unnamed namespace
+
+  ///\brief Summarize the contents of a Transform::Config. SmallSet and
+  /// DenseMap do not iterate in a defined order, so combine commutatively.
+  static uint64_t GetConfigFingerprint(const Transform::Config& TypeConfig,
+                                       bool fullyQualify) {
+    uint64_t FP = llvm::hash_combine(TypeConfig.m_toSkip.size(),
+                                     TypeConfig.m_toReplace.size(),
+                                     fullyQualify);
+    for (const Decl* D : TypeConfig.m_toSkip)
+      FP += llvm::hash_value(D);
+    for (auto&& R : TypeConfig.m_toReplace)
+      FP += llvm::hash_combine(R.first, R.second);
+    return FP;
+  }
+
   bool Analyze::IsWrapper(const FunctionDecl* ND) {
     if (!ND)
       return false;
@@ -1417,9 +1480,17 @@ namespace utils {
     QualType QT, const Transform::Config& TypeConfig,
     bool fullyQualify/*=true*/)
   {
-    return GetPartiallyDesugaredTypeImpl(Ctx,QT,TypeConfig,
+    TypeNameCache& Cache = TypeNameCache::get(Ctx);
+    std::pair<const void*, uint64_t> Key(QT.getAsOpaquePtr(),
+                               GetConfigFingerprint(TypeConfig, fullyQualify));
+    auto I = Cache.Desugared.find(Key);
+    if (I != Cache.Desugared.end())
+      return I->second;
+    QualType Result = GetPartiallyDesugaredTypeImpl(Ctx,QT,TypeConfig,
                                          /*qualifyType*/fullyQualify,
                                          /*qualifyTmpltArg*/fullyQualify);
+    Cache.Desugared[Key] = Result;
+    return Result;
   }
 
   NamespaceDecl* Lookup::Namespace(Sema* S, const char* Name,
@@ -1638,8 +1709,8 @@ namespace utils {
                                        Ty);
   }
 
-  QualType
-  TypeName::GetFullyQualifiedType(QualType QT, const ASTContext& Ctx) {
+  static QualType
+  ComputeFullyQualifiedType(QualType QT, const ASTContext& Ctx) {
     // Return the fully qualified type, if we need to recurse through any
     // template parameter, this needs to be merged somehow with
     // GetPartialDesugaredType.
@@ -1649,7 +1720,7 @@ namespace utils {
     if (llvm::isa<PointerType>(QT.getTypePtr())) {
       // Get the qualifiers.
       Qualifiers quals = QT.getQualifiers();
-      QT = GetFullyQualifiedType(QT->getPointeeType(), Ctx);
+      QT = TypeName::GetFullyQualifiedType(QT->getPointeeType(), Ctx);
       QT = Ctx.getPointerType(QT);
       // Add back the qualifiers.
       QT = Ctx.getQualifiedType(QT, quals);
@@ -1662,7 +1733,7 @@ namespace utils {
       // Get the qualifiers.
       bool isLValueRefTy = llvm::isa<LValueReferenceType>(QT.getTypePtr());
       Qualifiers quals = QT.getQualifiers();
-      QT = GetFullyQualifiedType(QT->getPointeeType(), Ctx);
+      QT = TypeName::GetFullyQualifiedType(QT->getPointeeType(), Ctx);
       // Add the r- or l-value reference type back to the desugared one.
       if (isLValueRefTy)
         QT = Ctx.getLValueReferenceType(QT);
@@ -1676,7 +1747,7 @@ namespace utils {
     // Strip deduced types.
     if (const AutoType* AutoTy = dyn_cast<AutoType>(QT.getTypePtr())) {
       if (!AutoTy->getDeducedType().isNull())
-        return GetFullyQualifiedType(AutoTy->getDeducedType(), Ctx);
+        return TypeName::GetFullyQualifiedType(AutoTy->getDeducedType(), Ctx);
     }
 
     // Remove the part of the type related to the type being a template
@@ -1753,13 +1824,60 @@ namespace utils {
     return QT;
   }
 
-  std::string TypeName::GetFullyQualifiedName(QualType QT,
-                                              const ASTContext &Ctx) {
-    QualType FQQT = GetFullyQualifiedType(QT, Ctx);
+  QualType
+  TypeName::GetFullyQualifiedType(QualType QT, const ASTContext& Ctx) {
+    // The recursion for pointees and template arguments comes back here,
+    // so those parts are shared between types, too.
+    TypeNameCache& Cache = TypeNameCache::get(Ctx);
+    auto I = Cache.FullyQualifiedTypes.find(QT.getAsOpaquePtr());
+    if (I != Cache.FullyQualifiedTypes.end())
+      return I->second;
+    QualType Result = ComputeFullyQualifiedType(QT, Ctx);
+    Cache.FullyQualifiedTypes[QT.getAsOpaquePtr()] = Result;
+    return Result;
+  }
+
+  static PrintingPolicy GetFullyQualifiedPrintingPolicy(const ASTContext& Ctx) {
     PrintingPolicy Policy(Ctx.getPrintingPolicy());
     Policy.SuppressScope = false;
     Policy.AnonymousTagLocations = false;
-    return FQQT.getAsString(Policy);
+    return Policy;
+  }
+
+  static const std::string&
+  GetFullyQualifiedNameImpl(QualType QT, const ASTContext& Ctx,
+                            const PrintingPolicy& Policy,
+                            TypeNameCache& Cache) {
+    auto I = Cache.FullyQualifiedNames.find(QT.getAsOpaquePtr());
+    if (I != Cache.FullyQualifiedNames.end())
+      return I->second;
+    QualType FQQT = TypeName::GetFullyQualifiedType(QT, Ctx);
+    return Cache.FullyQualifiedNames[QT.getAsOpaquePtr()]
+      = FQQT.getAsString(Policy);
+  }
+
+  std::string TypeName::GetFullyQualifiedName(QualType QT,
+                                              const ASTContext &Ctx) {
+    return GetFullyQualifiedNameImpl(QT, Ctx,
+                                     GetFullyQualifiedPrintingPolicy(Ctx),
+                                     TypeNameCache::get(Ctx));
+  }
+
+  void TypeName::GetFullyQualifiedNames(llvm::ArrayRef<QualType> QTs,
+                                        const ASTContext& Ctx,
+                                        std::vector<std::string>& Names) {
+    const PrintingPolicy Policy = GetFullyQualifiedPrintingPolicy(Ctx);
+    TypeNameCache& Cache = TypeNameCache::get(Ctx);
+    Names.reserve(Names.size() + QTs.size());
+    for (QualType QT : QTs)
+      Names.push_back(GetFullyQualifiedNameImpl(QT, Ctx, Policy, Cache));
+  }
+
+  void TypeName::InvalidateCache(const ASTContext& Ctx) {
+    std::lock_guard<std::mutex> Lock(TypeNameCache::getMutex());
+    auto I = TypeNameCache::getCaches().find(&Ctx);
+    if (I != TypeNameCache::getCaches().end())
+      I->second->clear();
   }
 
 } // end namespace utils
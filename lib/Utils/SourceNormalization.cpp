@@ -13,6 +13,7 @@
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/Lexer.h"
 
+#include <cassert>
 #include <utility>
 
 using namespace clang;
@@ -114,9 +115,10 @@ class MinimalPPLexer: public Lexer {
 
 public:
   ///\brief Construct a Lexer from LangOpts and source.
-  MinimalPPLexer(const LangOptions &LOpts, llvm::StringRef source):
+  MinimalPPLexer(const LangOptions &LOpts, llvm::StringRef source,
+                 size_t begin = 0):
     Lexer(SourceLocation(), LOpts,
-          source.begin(), source.begin(), source.end()),
+          source.begin(), source.begin() + begin, source.end()),
     LangOpts(LOpts) {}
 
   bool inPPDirective() const { return ParsingPreprocessorDirective; }
@@ -459,6 +461,8 @@ size_t cling::utils::getWrapPoint(std::string& source,
 
   while (true) {
     bool atEOF = Lex.Lex(Tok);
+    if (getFileOffset(Tok) >= end)
+      break;
     if (Lex.inPPDirective() || Tok.is(tok::eod)) {
       if (atEOF)
         break;
@@ -611,3 +615,80 @@ size_t cling::utils::getWrapPoint(std::string& source,
   // We have only had PP directives; no need to wrap.
   return std::string::npos;
 }
+
+size_t cling::utils::getChunkEnd(llvm::StringRef source, size_t begin,
+                                 size_t end, size_t minSize,
+                                 const clang::LangOptions& LangOpts) {
+  assert(begin <= end && end <= source.size() && "Invalid chunk bounds");
+  assert(source.data()[source.size()] == '\0' && "Lexer needs a NUL");
+  if (end - begin <= minSize)
+    return end;
+  minSize += begin;
+
+  // Lex the whole buffer, which is NUL-terminated, but stop at end.
+  MinimalPPLexer Lex(LangOpts, source, begin);
+  Token Tok;
+  unsigned Depth = 0, PPDepth = 0;
+  bool AfterHash = false;
+  // End of a statement or declaration that we might split after; whether
+  // we do depends on the token that follows it.
+  size_t Candidate = std::string::npos;
+
+  while (true) {
+    bool atEOF = Lex.Lex(Tok);
+    if (Lex.inPPDirective() || Tok.is(tok::eod)) {
+      if (AfterHash && Tok.is(tok::raw_identifier)) {
+        // Never split inside a conditional block.
+        StringRef keyword(Tok.getRawIdentifier());
+        if (keyword.starts_with("if"))
+          ++PPDepth;
+        else if (keyword.equals("endif") && PPDepth)
+          --PPDepth;
+      }
+      AfterHash = Tok.is(tok::hash);
+      if (atEOF)
+        break;
+      continue;
+    }
+    if (atEOF || Tok.isOneOf(tok::eof, tok::annot_repl_input_end))
+      break;
+
+    if (Candidate != std::string::npos) {
+      // Only split if the next token starts a new line and cannot continue
+      // the previous statement: 'if (c) a(); else b();', 'do {} while (c);'
+      // or 'struct S {} s;'.
+      bool Continues = !Tok.isAtStartOfLine() ||
+                       Tok.isOneOf(tok::semi, tok::comma, tok::equal,
+                                   tok::colon);
+      if (!Continues && Tok.is(tok::raw_identifier)) {
+        StringRef keyword(Tok.getRawIdentifier());
+        Continues = keyword.equals("else") || keyword.equals("while") ||
+                    keyword.equals("catch");
+      }
+      if (!Continues)
+        return Candidate;
+      Candidate = std::string::npos;
+    }
+
+    switch (Tok.getKind()) {
+    case tok::l_brace: case tok::l_paren: case tok::l_square:
+      ++Depth;
+      break;
+    case tok::r_brace: case tok::r_paren: case tok::r_square:
+      if (Depth)
+        --Depth;
+      if (Tok.is(tok::r_brace) && !Depth && !PPDepth
+          && getFileOffset(Tok) + 1 >= minSize)
+        Candidate = getFileOffset(Tok) + 1;
+      break;
+    case tok::semi:
+      if (!Depth && !PPDepth && getFileOffset(Tok) + 1 >= minSize)
+        Candidate = getFileOffset(Tok) + 1;
+      break;
+    default:
+      break;
+    }
+  }
+
+  return end;
+}
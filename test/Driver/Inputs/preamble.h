@@ -0,0 +1,8 @@
+#ifndef CLING_TEST_PREAMBLE_H
+#define CLING_TEST_PREAMBLE_H
+
+#include <cstdio>
+
+inline int preamble_magic() { return 42; }
+
+#endif // CLING_TEST_PREAMBLE_H
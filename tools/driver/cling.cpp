@@ -15,13 +15,19 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/FrontendTool/Utils.h"
 
+#include "llvm/Support/Chrono.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -74,11 +80,11 @@ static llvm::SmallString<512> getConfigDirPath() {
   return {};
 }
 
-static void runStartupFiles(cling::UserInterface& Ui) {
+static std::vector<std::string> getStartupFiles() {
   llvm::SmallString<512> StartupFilesDir{getConfigDirPath()};
 
   if (StartupFilesDir.empty()) {
-    return;
+    return {};
   }
 
   llvm::sys::path::append(StartupFilesDir, ".cling.d");
@@ -95,8 +101,11 @@ static void runStartupFiles(cling::UserInterface& Ui) {
   }
 
   std::sort(FilePaths.begin(), FilePaths.end());
+  return FilePaths;
+}
 
-  for (const auto& File : FilePaths) {
+static void runStartupFiles(cling::UserInterface& Ui) {
+  for (const auto& File : getStartupFiles()) {
     auto Result{cling::Interpreter::CompilationResult::kSuccess};
 
     Ui.getMetaProcessor()->process(".x " + File, Result, nullptr);
@@ -107,6 +116,240 @@ static void runStartupFiles(cling::UserInterface& Ui) {
   }
 }
 
+// Collects the #include directives a macro starts with, skipping blank lines,
+// line comments and a shebang.
+static void collectLeadingIncludes(llvm::StringRef Path,
+                                   std::vector<std::string>& Includes) {
+  auto Buffer = llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return;
+
+  llvm::StringRef Rest = (*Buffer)->getBuffer();
+  while (!Rest.empty()) {
+    llvm::StringRef Line;
+    std::tie(Line, Rest) = Rest.split('\n');
+    Line = Line.trim();
+    if (Line.empty() || Line.starts_with("//") || Line.starts_with("#!"))
+      continue;
+    if (!Line.starts_with("#") ||
+        !Line.drop_front().ltrim().starts_with("include"))
+      return;
+    Includes.push_back(Line.str());
+  }
+}
+
+// Extracts the prerequisites from a make-style dependency file.
+static std::vector<std::string> parseDependencyFile(llvm::StringRef Contents) {
+  std::vector<std::string> Deps;
+  size_t Colon = Contents.find(": ");
+  if (Colon == llvm::StringRef::npos)
+    return Deps;
+
+  std::string Dep;
+  for (size_t I = Colon + 2, E = Contents.size(); I < E; ++I) {
+    char C = Contents[I];
+    if (C == '\\' && I + 1 < E) {
+      char Next = Contents[I + 1];
+      if (Next == ' ' || Next == '#') {
+        Dep += Next;
+        ++I;
+        continue;
+      }
+      if (Next != '\n' && Next != '\r') {
+        Dep += C;
+        continue;
+      }
+      // Line continuation.
+      ++I;
+      C = ' ';
+    }
+    if (std::isspace(static_cast<unsigned char>(C))) {
+      if (!Dep.empty())
+        Deps.push_back(std::move(Dep));
+      Dep.clear();
+      continue;
+    }
+    Dep += C;
+  }
+  if (!Dep.empty())
+    Deps.push_back(std::move(Dep));
+  return Deps;
+}
+
+// The manifest records size and modification time of every file that went
+// into a preamble PCH, one "<size> <mtime> <path>" line per file.
+static bool writePreambleManifest(llvm::StringRef ManifestPath,
+                                  const std::vector<std::string>& Deps) {
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(ManifestPath, EC, llvm::sys::fs::OF_Text);
+  if (EC)
+    return false;
+  for (const std::string& Dep : Deps) {
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(Dep, Status))
+      return false;
+    OS << Status.getSize() << ' '
+       << llvm::sys::toTimeT(Status.getLastModificationTime()) << ' ' << Dep
+       << '\n';
+  }
+  OS.close();
+  return !OS.has_error();
+}
+
+static bool isPreambleUpToDate(llvm::StringRef ManifestPath) {
+  auto Buffer = llvm::MemoryBuffer::getFile(ManifestPath);
+  if (!Buffer)
+    return false;
+
+  llvm::StringRef Rest = (*Buffer)->getBuffer();
+  while (!Rest.empty()) {
+    llvm::StringRef Line, Size, MTime;
+    std::tie(Line, Rest) = Rest.split('\n');
+    if (Line.empty())
+      continue;
+    std::tie(Size, Line) = Line.split(' ');
+    std::tie(MTime, Line) = Line.split(' ');
+    uint64_t ExpectedSize;
+    int64_t ExpectedMTime;
+    if (Size.getAsInteger(10, ExpectedSize) ||
+        MTime.getAsInteger(10, ExpectedMTime))
+      return false;
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(Line, Status) ||
+        Status.getSize() != ExpectedSize ||
+        llvm::sys::toTimeT(Status.getLastModificationTime()) != ExpectedMTime)
+      return false;
+  }
+  return true;
+}
+
+// Returns a PCH for the block of #includes the startup macros begin with,
+// building it in the preamble cache if it is missing or out of date. The
+// cache entry is keyed on the includes, their search directories (including
+// the working directory) and the compiler flags, taken from the options the
+// session is set up with; the files it was built from are checked on every
+// start.
+static std::string getPreamblePCH(const char* Argv0,
+                                  const cling::InvocationOptions& Opts,
+                                  const std::vector<std::string>& Macros) {
+  std::vector<std::string> Includes;
+  std::vector<std::string> Flags;
+  for (const std::string& Macro : Macros) {
+    const size_t NumIncludes = Includes.size();
+    collectLeadingIncludes(Macro, Includes);
+    if (Includes.size() == NumIncludes)
+      continue;
+    // Quoted includes are relative to the macro.
+    llvm::SmallString<512> Dir(Macro);
+    llvm::sys::fs::make_absolute(Dir);
+    llvm::sys::path::remove_filename(Dir);
+    Flags.push_back("-I" + Dir.str().str());
+  }
+  if (Includes.empty())
+    return {};
+
+  // Skip the program name and the input macros.
+  const std::vector<const char*>& Remaining = Opts.CompilerOpts.Remaining;
+  for (auto I = Remaining.begin() + 1, E = Remaining.end(); I != E; ++I) {
+    if (!::strcmp(*I, "-include-pch"))
+      return {};
+    if (std::find(Opts.Inputs.begin(), Opts.Inputs.end(), *I) ==
+        Opts.Inputs.end())
+      Flags.push_back(*I);
+  }
+  // The session searches "." last, see main(); so does the preamble.
+  Flags.push_back("-I.");
+  llvm::SmallString<512> CWD;
+  if (llvm::sys::fs::current_path(CWD))
+    return {};
+
+  llvm::MD5 Hash;
+  Hash.update(cling::Interpreter::getVersion());
+  Hash.update(CWD);
+  Hash.update("\n");
+  for (const std::string& Flag : Flags) {
+    Hash.update(Flag);
+    Hash.update("\n");
+  }
+  for (const std::string& Include : Includes) {
+    Hash.update(Include);
+    Hash.update("\n");
+  }
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+
+  llvm::SmallString<512> BaseDir(Opts.PreambleCachePath);
+  llvm::sys::path::append(BaseDir, "preamble-" + Result.digest().str());
+  const std::string Base = BaseDir.str().str();
+  const std::string PCHPath = Base + ".pch";
+  const std::string ManifestPath = Base + ".deps";
+  if (llvm::sys::fs::exists(PCHPath) && isPreambleUpToDate(ManifestPath)) {
+    if (Opts.Verbose())
+      std::cerr << "Using preamble PCH " << PCHPath << '\n';
+    return PCHPath;
+  }
+
+  if (Opts.Verbose())
+    std::cerr << "Building preamble PCH " << PCHPath << '\n';
+
+  const std::string HeaderPath = Base + ".h";
+  llvm::SmallString<512> TmpHeaderPath, TmpPCHPath;
+  if (llvm::sys::fs::create_directories(Opts.PreambleCachePath) ||
+      llvm::sys::fs::createUniqueFile(Base + "-%%%%%%.h", TmpHeaderPath) ||
+      llvm::sys::fs::createUniqueFile(Base + "-%%%%%%.pch", TmpPCHPath)) {
+    std::cerr << "Cannot write to preamble cache "
+              << Opts.PreambleCachePath << '\n';
+    if (!TmpHeaderPath.empty())
+      llvm::sys::fs::remove(TmpHeaderPath);
+    return {};
+  }
+  const std::string DepPath = TmpPCHPath.str().str() + ".d";
+  {
+    // Another cling might be building from the header right now; replace it
+    // in one go rather than truncating it. Its contents only depend on the
+    // cache key, so they stay the same.
+    std::ofstream Header(TmpHeaderPath.c_str());
+    for (const std::string& Include : Includes)
+      Header << Include << '\n';
+  }
+  if (llvm::sys::fs::rename(TmpHeaderPath, HeaderPath)) {
+    std::cerr << "Cannot write to preamble cache "
+              << Opts.PreambleCachePath << '\n';
+    llvm::sys::fs::remove(TmpHeaderPath);
+    llvm::sys::fs::remove(TmpPCHPath);
+    return {};
+  }
+
+  std::vector<const char*> Args{Argv0};
+  for (const std::string& Flag : Flags)
+    Args.push_back(Flag.c_str());
+  for (const char* Arg : {"-x", "c++-header", HeaderPath.c_str(),
+                          "-o", TmpPCHPath.c_str(),
+                          "-MD", "-MF", DepPath.c_str()})
+    Args.push_back(Arg);
+
+  bool Built = false;
+  {
+    // Like `cling -x c++-header Preamble.h -o Preamble.pch`.
+    cling::Interpreter Builder(Args.size(), Args.data());
+    if (clang::CompilerInstance* CI = Builder.getCIOrNull())
+      Built = !Builder.isValid() && ExecuteCompilerInvocation(CI) &&
+              checkDiagErrors(CI) == EXIT_SUCCESS;
+  }
+
+  auto DepFile = llvm::MemoryBuffer::getFile(DepPath);
+  if (Built && DepFile)
+    Built = writePreambleManifest(ManifestPath,
+                                  parseDependencyFile((*DepFile)->getBuffer()));
+  llvm::sys::fs::remove(DepPath);
+  if (!Built || llvm::sys::fs::rename(TmpPCHPath, PCHPath)) {
+    std::cerr << "Building preamble PCH failed, parsing startup headers\n";
+    llvm::sys::fs::remove(TmpPCHPath);
+    return {};
+  }
+  return PCHPath;
+}
+
 int main( int argc, char **argv ) {
 
   llvm::llvm_shutdown_obj shutdownTrigger;
@@ -130,8 +373,24 @@ int main( int argc, char **argv ) {
   }
 #endif
 
+  cling::InvocationOptions InterpOpts(argc, argv);
+
+  // Reuse (or build) a PCH of the #includes the startup macros begin with.
+  std::string PreamblePCH;
+  if (!InterpOpts.PreambleCachePath.empty()) {
+    std::vector<std::string> Macros = getStartupFiles();
+    if (!InterpOpts.IsInteractive() &&
+        llvm::sys::fs::is_regular_file(InterpOpts.Inputs.front()))
+      Macros.push_back(InterpOpts.Inputs.front());
+    PreamblePCH = getPreamblePCH(argv[0], InterpOpts, Macros);
+    if (!PreamblePCH.empty()) {
+      InterpOpts.CompilerOpts.Remaining.push_back("-include-pch");
+      InterpOpts.CompilerOpts.Remaining.push_back(PreamblePCH.c_str());
+    }
+  }
+
   // Set up the interpreter
-  cling::Interpreter Interp(argc, argv);
+  cling::Interpreter Interp(InterpOpts);
   const cling::InvocationOptions& Opts = Interp.getOptions();
 
   if (!Interp.isValid()) {